@@ -0,0 +1,181 @@
+#include "asset_loader.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+using Clock = std::chrono::high_resolution_clock;
+
+static float elapsedMs(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+ThreadPool::ThreadPool(unsigned int nThreads)
+: isStopping_(false)
+{
+    if (nThreads == 0)
+        nThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned int i = 0; i < nThreads; i++)
+        workers_.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        isStopping_ = true;
+    }
+    condition_.notify_all();
+    for (std::thread& worker : workers_)
+        worker.join();
+}
+
+void ThreadPool::enqueue(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back(std::move(job));
+    }
+    condition_.notify_one();
+}
+
+unsigned int ThreadPool::getThreadCount() const
+{
+    return workers_.size();
+}
+
+void ThreadPool::workerLoop()
+{
+    while (true)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]{ return isStopping_ || !jobs_.empty(); });
+            if (jobs_.empty())
+                return;
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        job();
+    }
+}
+
+
+AssetLoader::AssetLoader()
+: nPending_(0), startTime_(Clock::now())
+{
+}
+
+void AssetLoader::enqueue(const std::string& name, DecodeFunction decode)
+{
+    size_t index;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (timings_.empty())
+            startTime_ = Clock::now();
+        index = timings_.size();
+        timings_.push_back({name, 0.0f, 0.0f});
+        nPending_++;
+    }
+
+    pool_.enqueue([this, index, decode = std::move(decode)]()
+    {
+        Clock::time_point start = Clock::now();
+        UploadFunction upload;
+        try
+        {
+            upload = decode();
+        }
+        catch (std::exception& e)
+        {
+            std::cout << "Error loading asset: " << e.what() << std::endl;
+        }
+        float decodeMs = elapsedMs(start, Clock::now());
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            timings_[index].decodeMs = decodeMs;
+            uploads_.push_back({index, std::move(upload)});
+        }
+        condition_.notify_one();
+    });
+}
+
+void AssetLoader::finish()
+{
+    while (true)
+    {
+        PendingUpload pending;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (nPending_ == 0)
+                break;
+            condition_.wait(lock, [this]{ return !uploads_.empty(); });
+            pending = std::move(uploads_.front());
+            uploads_.pop_front();
+        }
+        runUpload(pending);
+    }
+
+    printReport();
+}
+
+void AssetLoader::update()
+{
+    bool isBatchDone = false;
+    while (true)
+    {
+        PendingUpload pending;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (uploads_.empty())
+                break;
+            pending = std::move(uploads_.front());
+            uploads_.pop_front();
+        }
+        runUpload(pending);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        isBatchDone = nPending_ == 0;
+    }
+
+    if (isBatchDone)
+        printReport();
+}
+
+void AssetLoader::runUpload(PendingUpload& pending)
+{
+    Clock::time_point start = Clock::now();
+    if (pending.upload)
+        pending.upload();
+    float uploadMs = elapsedMs(start, Clock::now());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    timings_[pending.index].uploadMs = uploadMs;
+    nPending_--;
+}
+
+void AssetLoader::printReport()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (timings_.empty())
+        return;
+
+    float totalMs = elapsedMs(startTime_, Clock::now());
+
+    std::cout << "Asset loading report (" << pool_.getThreadCount() << " threads)" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    for (const AssetTiming& timing : timings_)
+    {
+        std::cout << "    decode " << std::setw(8) << timing.decodeMs << " ms"
+                  << "    upload " << std::setw(8) << timing.uploadMs << " ms"
+                  << "    " << timing.name << std::endl;
+    }
+    std::cout << "    total  " << std::setw(8) << totalMs << " ms\n" << std::endl;
+    std::cout << std::defaultfloat;
+
+    timings_.clear();
+}
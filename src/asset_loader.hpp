@@ -0,0 +1,82 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned int nThreads = 0);
+    ~ThreadPool();
+
+    void enqueue(std::function<void()> job);
+
+    unsigned int getThreadCount() const;
+
+private:
+    void workerLoop();
+
+private:
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> jobs_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool isStopping_;
+};
+
+
+// Décode les assets sur un bassin de fils, puis exécute seulement les
+// téléversements OpenGL sur le fil principal (celui du contexte).
+class AssetLoader
+{
+    struct AssetTiming
+    {
+        std::string name;
+        float decodeMs;
+        float uploadMs;
+    };
+
+    struct PendingUpload
+    {
+        size_t index;
+        std::function<void()> upload;
+    };
+
+public:
+    using UploadFunction = std::function<void()>;
+    using DecodeFunction = std::function<UploadFunction()>;
+
+    AssetLoader();
+
+    void enqueue(const std::string& name, DecodeFunction decode);
+
+    // Bloque jusqu'à ce que tous les assets soient téléversés, puis affiche le rapport.
+    void finish();
+
+    // Téléverse les assets déjà décodés sans bloquer. À appeler à chaque trame.
+    void update();
+
+private:
+    void runUpload(PendingUpload& pending);
+    void printReport();
+
+private:
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<PendingUpload> uploads_;
+    std::vector<AssetTiming> timings_;
+    size_t nPending_;
+
+    std::chrono::high_resolution_clock::time_point startTime_;
+
+    ThreadPool pool_;
+};
+
+#endif // ASSET_LOADER_H
@@ -1,5 +1,6 @@
 #include "car.hpp"
 
+#include <algorithm>
 #include <cmath>
 
 #include <glm/glm.hpp>
@@ -10,34 +11,30 @@
 using namespace gl;
 using namespace glm;
 
-#include <map>
 
-#include "shaders.hpp"
-#include "uniform_buffer.hpp"
-
-struct Material
-{
-    glm::vec4 emission;
-    glm::vec4 ambient;
-    glm::vec4 diffuse;
-    glm::vec3 specular;
-    GLfloat shininess;
-};
+#include "asset_loader.hpp"
+#include "frustum_culling.hpp"
+#include "material.hpp"
+#include "shadow_maps.hpp"
+#include "transform_buffer.hpp"
 
 Car::Car()
-: position(0.0f, 0.0f, -20.0f), orientation(0.0f, 0.0f), speed(0.f)
+: frameTransform_(0), firstMaterialIndex_(0), partDraws_{0, 0}, windowDraws_{0, 0}
+, position(0.0f, 0.0f, -20.0f), orientation(0.0f, 0.0f), speed(0.f)
 , wheelsRollAngle(0.f), steeringAngle(0.f)
 , isHeadlightOn(false), isBraking(false)
 , isLeftBlinkerActivated(false), isRightBlinkerActivated(false)
 , isBlinkerOn(false), blinkerTimer(0.f)
-{}
+{
+    std::fill(isPartVisible_, isPartVisible_ + N_PARTS, 1);
+}
 
-void Car::loadModels()
+void Car::loadModels(AssetLoader& loader)
 {
-    frame_.load("../models/frame.ply");
-    wheel_.load("../models/wheel.ply");
-    blinker_.load("../models/blinker.ply");
-    light_.load("../models/light.ply");
+    frame_.load("../models/frame.ply", loader);
+    wheel_.load("../models/wheel.ply", loader);
+    blinker_.load("../models/blinker.ply", loader);
+    light_.load("../models/light.ply", loader);
     const char* WINDOW_MODEL_PATHES[] = 
     {
         "../models/window.f.ply",
@@ -49,7 +46,7 @@ void Car::loadModels()
     };
     for (unsigned int i = 0; i < 6; ++i)
     {
-        windows[i].load(WINDOW_MODEL_PATHES[i]);
+        windows[i].load(WINDOW_MODEL_PATHES[i], loader);
     }
 }
 
@@ -106,192 +103,99 @@ void Car::update(float deltaTime)
     carModel = glm::rotate(carModel, orientation.x, glm::vec3(1.0f, 0.0f, 0.0f));
 }
 
-void Car::draw(const glm::mat4& projView, const glm::mat4& view, bool useOutline)
+static const glm::vec3 WHEEL_POSITIONS[] =
 {
-    glm::mat4 carModel = glm::mat4(1.0f);
-    carModel = glm::translate(carModel, position);
-    carModel = glm::rotate(carModel, orientation.y, glm::vec3(0.0f, 1.0f, 0.0f)); 
-    carModel = glm::rotate(carModel, orientation.x, glm::vec3(1.0f, 0.0f, 0.0f)); 
-    drawFrame(projView, view, carModel, useOutline);
-    drawWheels(projView, view, carModel, useOutline);
-    drawHeadlights(projView, view, carModel, useOutline);
-}
-    
-void Car::drawFrame(const glm::mat4& projView, const glm::mat4& view, const glm::mat4& carModel, bool useOutline)
-{
-    glm::mat4 model = glm::translate(carModel, glm::vec3(0.0f, 0.25f, 0.0f));
-    glm::mat4 frameMVP = projView * model;
-    if (useOutline) {
-        glUniformMatrix4fv(edgeEffectShader->mvpULoc, 1, GL_FALSE, glm::value_ptr(frameMVP));
-    } else {
-        celShadingShader->setMatrices(frameMVP, view, model);
-    }
-    frame_.draw();
-}
+    glm::vec3(-1.29f, 0.245f, -0.57f),
+    glm::vec3(-1.29f, 0.245f,  0.57f),
+    glm::vec3( 1.4f , 0.245f, -0.57f),
+    glm::vec3( 1.4f , 0.245f,  0.57f)
+};
 
-void Car::drawWheel(const glm::mat4& projView, const glm::mat4& view, glm::mat4 carModel, const bool isLeft, const bool isFront, bool useOutline)
+static const glm::vec3 HEADLIGHT_POSITIONS[] =
 {
-    const float OFFSET = -0.10124f;
-
-    if (isFront) {
-        carModel = glm::rotate(carModel, glm::radians(-steeringAngle), glm::vec3(0.0f, 1.0f, 0.0f));
-    }
-
-    float roll = isLeft ? -wheelsRollAngle : wheelsRollAngle;
-
-    carModel = glm::rotate(carModel, roll, glm::vec3(0.0f, 0.0f, 1.0f));
-    carModel = glm::translate(carModel, glm::vec3(0.0f, 0.0f, OFFSET));
-
-    glm::mat4 mvp = projView * carModel;
-    if (useOutline) {
-        glUniformMatrix4fv(edgeEffectShader->mvpULoc, 1, GL_FALSE, glm::value_ptr(mvp));
-    } else {
-        celShadingShader->setMatrices(mvp, view, carModel);
-    }
-    wheel_.draw();
-}
+    glm::vec3(-1.9650f, 0.64f, -0.45f),
+    glm::vec3(-1.9650f, 0.64f,  0.45f),
+    glm::vec3( 2.0019f, 0.38f, -0.45f),
+    glm::vec3( 2.0019f, 0.38f,  0.45f)
+};
 
-void Car::drawWheels(const glm::mat4& projView, const glm::mat4& view, const glm::mat4& carModel, bool useOutline)
+// Matériaux des pièces, à partir de firstMaterialIndex_.
+enum CarMaterial : GLuint
 {
-    const glm::vec3 WHEEL_POSITIONS[] =
-    {
-        glm::vec3(-1.29f, 0.245f, -0.57f),
-        glm::vec3(-1.29f, 0.245f,  0.57f),
-        glm::vec3( 1.4f , 0.245f, -0.57f),
-        glm::vec3( 1.4f , 0.245f,  0.57f)
-    };
-
-    for (int i = 0; i < 4; ++i) {
-        glm::mat4 model = carModel;
-        model = glm::translate(model, WHEEL_POSITIONS[i]);
-
-        bool isFront = (i <= 1);
-        bool isLeft = (i % 2 != 0);
-
-        if (isLeft) {
-            model = glm::rotate(model, glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        }
-
-        drawWheel(projView, view, model, isLeft, isFront, useOutline);
-    }
-}
+    CAR_BODY,
+    CAR_FRONT_LIGHT,
+    CAR_FRONT_LIGHT_ON,
+    CAR_REAR_LIGHT,
+    CAR_REAR_LIGHT_ON,
+    CAR_BLINKER,
+    CAR_BLINKER_ON
+};
 
-void Car::drawBlinker(const glm::mat4& projView, const glm::mat4& view, const glm::mat4& headlightModel, bool isLeftHeadlight, bool useOutline)
+static Material lightMaterial(const glm::vec3& color, const glm::vec3& emission)
 {
-    glm::mat4 model = glm::translate(headlightModel, glm::vec3(0.0f, 0.0f, -0.06065f));
-    glm::mat4 mvp = projView * model;
-
-    if (useOutline) {
-        glUniformMatrix4fv(edgeEffectShader->mvpULoc, 1, GL_FALSE, glm::value_ptr(mvp));
-        blinker_.draw();
-        return;
-    }
-
-    bool isBlinkerActivated = (isLeftHeadlight  && isLeftBlinkerActivated) ||
-                              (!isLeftHeadlight && isRightBlinkerActivated);
-
-    const glm::vec3 ON_COLOR (1.0f, 0.7f , 0.3f );
-    const glm::vec3 OFF_COLOR (0.5f, 0.35f, 0.15f);
-    Material blinkerMat = 
+    return
     {
-        {0.0f, 0.0f, 0.0f, 0.0f},
-        {OFF_COLOR, 0.0f},
-        {OFF_COLOR, 0.0f},
-        {OFF_COLOR},
-        10.0f
+        {emission, 0.0f},
+        {color, 0.0f},
+        {color, 0.0f},
+        {color},
+        10.0f,
+        LAYER_CAR,
+        true,
+        0.0f
     };
-
-    if (isBlinkerOn && isBlinkerActivated)
-    {
-        blinkerMat.emission = glm::vec4(ON_COLOR, 0.0f);
-    }
-    material->updateData(&blinkerMat, 0, sizeof(Material));
-
-    celShadingShader->setMatrices(mvp, view, model);
-    blinker_.draw();
 }
 
-void Car::drawLight(const glm::mat4& projView, const glm::mat4& view, const glm::mat4& headLightModel, bool isFrontHeadlight, bool useOutline)
+void Car::initMaterials(const Material& bodyMaterial, GLuint firstMaterialIndex, Material* materials)
 {
-    glm::mat4 model = glm::translate(headLightModel, glm::vec3(0.0f, 0.0f, 0.029));
-    glm::mat4 mvp = projView * model;
-
-    if (useOutline) {
-        glUniformMatrix4fv(edgeEffectShader->mvpULoc, 1, GL_FALSE, glm::value_ptr(mvp));
-        light_.draw();
-        return;
-    }
-
     const glm::vec3 FRONT_ON_COLOR (1.0f, 1.0f, 1.0f);
     const glm::vec3 FRONT_OFF_COLOR(0.5f, 0.5f, 0.5f);
     const glm::vec3 REAR_ON_COLOR  (1.0f, 0.1f, 0.1f);
     const glm::vec3 REAR_OFF_COLOR (0.5f, 0.1f, 0.1f);
+    const glm::vec3 BLINKER_ON_COLOR (1.0f, 0.7f , 0.3f );
+    const glm::vec3 BLINKER_OFF_COLOR(0.5f, 0.35f, 0.15f);
+    const glm::vec3 NO_EMISSION(0.0f);
+
+    firstMaterialIndex_ = firstMaterialIndex;
+    materials[CAR_BODY] = bodyMaterial;
+    materials[CAR_FRONT_LIGHT] = lightMaterial(FRONT_OFF_COLOR, NO_EMISSION);
+    materials[CAR_FRONT_LIGHT_ON] = lightMaterial(FRONT_OFF_COLOR, FRONT_ON_COLOR);
+    materials[CAR_REAR_LIGHT] = lightMaterial(REAR_OFF_COLOR, NO_EMISSION);
+    materials[CAR_REAR_LIGHT_ON] = lightMaterial(REAR_OFF_COLOR, REAR_ON_COLOR);
+    materials[CAR_BLINKER] = lightMaterial(BLINKER_OFF_COLOR, NO_EMISSION);
+    materials[CAR_BLINKER_ON] = lightMaterial(BLINKER_OFF_COLOR, BLINKER_ON_COLOR);
+}
 
-    const float Z_OFFSET = 0.029;
+void Car::updateTransforms(TransformBuffer& transforms)
+{
+    // Les fenêtres partagent la matrice de la carrosserie.
+    GLuint bodyMaterial = firstMaterialIndex_ + CAR_BODY;
+    frameTransform_ = transforms.push(glm::translate(carModel, glm::vec3(0.0f, 0.25f, 0.0f)), bodyMaterial);
 
-    Material lightFrontMat = 
-    {
-        {0.0f, 0.0f, 0.0f, 0.0f},
-        {FRONT_OFF_COLOR, 0.0f},
-        {FRONT_OFF_COLOR, 0.0f},
-        {FRONT_OFF_COLOR},
-        10.0f
-    };
-    
-    Material lightRearMat = 
-    {
-        {0.0f, 0.0f, 0.0f, 0.0f},
-        {REAR_OFF_COLOR, 0.0f},
-        {REAR_OFF_COLOR, 0.0f},
-        {REAR_OFF_COLOR},
-        10.0f
-    };
+    const float WHEEL_OFFSET = -0.10124f;
+    for (int i = 0; i < 4; ++i) {
+        glm::mat4 model = glm::translate(carModel, WHEEL_POSITIONS[i]);
 
-    if (isFrontHeadlight) {
-        if (isHeadlightOn) {
-            lightFrontMat.emission = glm::vec4(FRONT_ON_COLOR, 0.0f);
+        bool isFront = (i <= 1);
+        bool isLeft = (i % 2 != 0);
+
+        if (isLeft) {
+            model = glm::rotate(model, glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f));
         }
-        material->updateData(&lightFrontMat, 0, sizeof(Material));
-    } else {
-        if (isBraking) {
-            lightRearMat.emission = glm::vec4(REAR_ON_COLOR, 0.0f);
+        if (isFront) {
+            model = glm::rotate(model, glm::radians(-steeringAngle), glm::vec3(0.0f, 1.0f, 0.0f));
         }
-        material->updateData(&lightRearMat, 0, sizeof(Material));
-    }
 
-    celShadingShader->setMatrices(mvp, view, model);
-    light_.draw();
-}
+        float roll = isLeft ? -wheelsRollAngle : wheelsRollAngle;
+        model = glm::rotate(model, roll, glm::vec3(0.0f, 0.0f, 1.0f));
+        model = glm::translate(model, glm::vec3(0.0f, 0.0f, WHEEL_OFFSET));
 
-void Car::drawHeadlight(const glm::mat4& projView, const glm::mat4& view, glm::mat4 headLightModel, bool isFrontHeadlight, bool isLeftHeadlight, bool useOutline) 
-{
-    if (isFrontHeadlight && isLeftHeadlight) {
-        headLightModel = glm::rotate(headLightModel, glm::radians(5.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        transforms.push(model, bodyMaterial);
     }
-    else if (isFrontHeadlight)
-    {
-        headLightModel = glm::rotate(headLightModel, glm::radians(-5.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-    }
-
-    drawLight(projView, view, headLightModel, isFrontHeadlight, useOutline);
-    drawBlinker(projView, view, headLightModel, isLeftHeadlight, useOutline);
-}
-
-void Car::drawHeadlights(const glm::mat4& projView, const glm::mat4& view, const glm::mat4& carModel, bool useOutline)
-{
-    const glm::vec3 HEADLIGHT_POSITIONS[] =
-    {
-        glm::vec3(-1.9650f, 0.64f, -0.45f),
-        glm::vec3(-1.9650f, 0.64f,  0.45f),
-        glm::vec3( 2.0019f, 0.38f, -0.45f),
-        glm::vec3( 2.0019f, 0.38f,  0.45f)
-    };
-
-    glm::mat4 baseModel = glm::translate(carModel, glm::vec3(0.0f, 0.25f, 0.0f));
 
+    glm::mat4 headlightModels[4];
     for (int i = 0; i < 4; ++i) {
-        glm::mat4 model = carModel;
-        model = glm::translate(model, HEADLIGHT_POSITIONS[i]);
+        glm::mat4 model = glm::translate(carModel, HEADLIGHT_POSITIONS[i]);
 
         bool isFrontHeadlight = HEADLIGHT_POSITIONS[i].x < 0;
         bool isLeftHeadlight = HEADLIGHT_POSITIONS[i].z > 0;
@@ -299,51 +203,90 @@ void Car::drawHeadlights(const glm::mat4& projView, const glm::mat4& view, const
         if (isLeftHeadlight) {
             model = glm::rotate(model, glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f)); 
         }
+        if (isFrontHeadlight && isLeftHeadlight) {
+            model = glm::rotate(model, glm::radians(5.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        }
+        else if (isFrontHeadlight) {
+            model = glm::rotate(model, glm::radians(-5.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        }
+        headlightModels[i] = model;
+    }
 
-        drawHeadlight(projView, view, model, isFrontHeadlight, isLeftHeadlight, useOutline);
+    for (int i = 0; i < 4; ++i) {
+        bool isFrontHeadlight = HEADLIGHT_POSITIONS[i].x < 0;
+        GLuint material = isFrontHeadlight ? (isHeadlightOn ? CAR_FRONT_LIGHT_ON : CAR_FRONT_LIGHT)
+                                           : (isBraking ? CAR_REAR_LIGHT_ON : CAR_REAR_LIGHT);
+        transforms.push(glm::translate(headlightModels[i], glm::vec3(0.0f, 0.0f, 0.029f)),
+                        firstMaterialIndex_ + material);
     }
+
+    for (int i = 0; i < 4; ++i) {
+        bool isLeftHeadlight = HEADLIGHT_POSITIONS[i].z > 0;
+        bool isBlinkerActivated = (isLeftHeadlight  && isLeftBlinkerActivated) ||
+                                  (!isLeftHeadlight && isRightBlinkerActivated);
+        GLuint material = isBlinkerOn && isBlinkerActivated ? CAR_BLINKER_ON : CAR_BLINKER;
+        transforms.push(glm::translate(headlightModels[i], glm::vec3(0.0f, 0.0f, -0.06065f)),
+                        firstMaterialIndex_ + material);
+    }
+
+    // Les pièces ont des transformations consécutives à partir de la carrosserie.
+    for (int i = 0; i < N_PARTS; i++)
+        partSpheres_[i] = transformSphere(getPartModel(i).bounds().sphere, transforms.getModel(frameTransform_ + i));
 }
 
-void Car::drawWindows(const glm::mat4& projView, const glm::mat4& view)
+const Model& Car::getPartModel(int part) const
 {
-    const glm::vec3 WINDOW_POSITION[] =
-    {
-        glm::vec3(-0.813, 0.755, 0.0),
-        glm::vec3(1.092, 0.761, 0.0),
-        glm::vec3(-0.3412, 0.757, 0.51),
-        glm::vec3(-0.3412, 0.757, -0.51),
-        glm::vec3(0.643, 0.756, 0.508),
-        glm::vec3(0.643, 0.756, -0.508)
-    };
-    
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glDisable(GL_CULL_FACE);
+    return part < FIRST_WHEEL_PART ? frame_
+         : part < FIRST_LIGHT_PART ? wheel_
+         : part < FIRST_BLINKER_PART ? light_
+         : blinker_;
+}
 
-    glm::mat4 carDrawModel = glm::mat4(1.0f);
-    carDrawModel = glm::translate(carDrawModel, position);
-    carDrawModel = glm::rotate(carDrawModel, orientation.y, glm::vec3(0.0f, 1.0f, 0.0f)); 
-    carDrawModel = glm::rotate(carDrawModel, orientation.x, glm::vec3(1.0f, 0.0f, 0.0f));
+void Car::cull(const Frustum& frustum)
+{
+    frustum.cull(partSpheres_, N_PARTS, isPartVisible_);
 
-    std::map<float, unsigned int> sorted;
-    for (unsigned int i = 0; i < 6; i++)
+    // Toutes les pièces visibles sont soumises en un seul appel.
+    commands_.clear();
+    for (int i = 0; i < N_PARTS; i++)
     {
-        glm::vec3 windowWorldPos = glm::vec3(carDrawModel * glm::vec4(WINDOW_POSITION[i], 1.0f));
-        glm::vec4 windowViewPos = view * glm::vec4(windowWorldPos, 1.0f);
-        float distance = glm::length(glm::vec3(windowViewPos));
-        sorted[distance] = i;
+        if (isPartVisible_[i])
+            commands_.add(getPartModel(i), {frameTransform_ + i, 1});
     }
+    partDraws_ = commands_.endGroup();
 
-    for (std::map<float, unsigned int>::reverse_iterator it = sorted.rbegin(); it != sorted.rend(); ++it)
+    // Les fenêtres sont dans le volume de la carrosserie.
+    if (isPartVisible_[0])
     {
-        unsigned int i = it->second;
-
-        glm::mat4 model = glm::translate(carDrawModel, glm::vec3(0.0f, 0.25f, 0.0f));
-        glm::mat4 mvp = projView * model;
-        celShadingShader->setMatrices(mvp, view, model);
-        windows[i].draw();
+        for (const Model& window : windows)
+            commands_.add(window, {frameTransform_, 1});
     }
+    windowDraws_ = commands_.endGroup();
+    commands_.upload();
+}
+
+void Car::addShadowCasters(ShadowMaps& shadowMaps)
+{
+    // Les phares et clignotants sont trop petits pour projeter une ombre visible.
+    shadowMaps.addCaster(frame_, {frameTransform_, 1}, partSpheres_[0]);
+    for (int i = FIRST_WHEEL_PART; i < FIRST_LIGHT_PART; ++i)
+        shadowMaps.addCaster(wheel_, {frameTransform_ + i, 1}, partSpheres_[i]);
+}
+
+void Car::draw()
+{
+    if (partDraws_.count > 0)
+        commands_.draw(partDraws_);
+}
+
+void Car::drawWindows()
+{
+    if (windowDraws_.count == 0)
+        return;
 
+    // Pas de tri: l'ordre est indifférent pour TransparencyPass, et la passe
+    // du stencil n'écrit pas la couleur.
+    glDisable(GL_CULL_FACE);
+    commands_.draw(windowDraws_);
     glEnable(GL_CULL_FACE);
-    glDisable(GL_BLEND);
-}
\ No newline at end of file
+}
@@ -1,35 +1,49 @@
 #pragma once
 
+#include <cstdint>
+
 #include <glbinding/gl/gl.h>
 #include <glm/glm.hpp>
 
+#include "geometry_pool.hpp"
 #include "model.hpp"
-#include "uniform_buffer.hpp"
 
-class EdgeEffect;
-class CelShading;
+class AssetLoader;
+class Frustum;
+class ShadowMaps;
+class TransformBuffer;
+struct Material;
 
 class Car
 {   
 public:
     Car();
     
-    void loadModels();
+    void loadModels(AssetLoader& loader);
+
+    // Matériaux des pièces, copiés dans la table des matériaux à partir de
+    // firstMaterialIndex. Les phares et clignotants y ont un état éteint et
+    // un état allumé, choisi par instance dans updateTransforms().
+    static constexpr int N_MATERIALS = 7;
+    void initMaterials(const Material& bodyMaterial, GLuint firstMaterialIndex, Material* materials);
     
     void update(float deltaTime);
     
-    void draw(const glm::mat4& projView, const glm::mat4& view, bool useOutline);
+    // Écrit les matrices de toutes les pièces, une fois par image, avant les dessins.
+    void updateTransforms(TransformBuffer& transforms);
+    // Après updateTransforms().
+    void addShadowCasters(ShadowMaps& shadowMaps);
+    // Après updateTransforms(); les pièces hors du volume ne sont pas dessinées.
+    void cull(const Frustum& frustum);
+    
+    // Le VAO de GeometryPool doit être lié. Les pièces lisent leur matériau
+    // dans la table (InstancedCelShading).
+    void draw();
 
-    void drawWindows(const glm::mat4& projView, const glm::mat4& view);
+    void drawWindows();
     
 private:
-    void drawFrame(const glm::mat4& projView, const glm::mat4& view, const glm::mat4& carModel, bool useOutline);
-    void drawWheels(const glm::mat4& projView, const glm::mat4& view, const glm::mat4& carModel, bool useOutline);
-    void drawWheel(const glm::mat4& projView, const glm::mat4& view, glm::mat4 carModel, const bool isLeft, const bool isFront, bool useOutline);
-    void drawHeadlights(const glm::mat4& projView, const glm::mat4& view, const glm::mat4& carModel, bool useOutline);
-    void drawHeadlight(const glm::mat4& projView, const glm::mat4& view, glm::mat4 headLightModel, bool isFrontHeadlight, bool isLeftHeadlight, bool useOutline);
-    void drawLight(const glm::mat4& projView, const glm::mat4& view, const glm::mat4& headLightModel, bool isFrontHeadlight, bool useOutline);
-    void drawBlinker(const glm::mat4& projView, const glm::mat4& view, const glm::mat4& headlightModel, bool isLeftHeadlight, bool useOutline);
+    const Model& getPartModel(int part) const;
     
 private:    
     Model windows[6];
@@ -38,13 +52,27 @@ private:
     Model blinker_;
     Model light_;
     
+    // Indice dans le tampon de transformations de l'image courante; les autres
+    // pièces suivent.
+    GLuint frameTransform_;
+    GLuint firstMaterialIndex_;
+    
+    // Carrosserie, 4 roues, 4 phares et 4 clignotants, dans l'ordre des transformations.
+    static constexpr int FIRST_WHEEL_PART = 1;
+    static constexpr int FIRST_LIGHT_PART = 5;
+    static constexpr int FIRST_BLINKER_PART = 9;
+    static constexpr int N_PARTS = 13;
+    BoundingSphere partSpheres_[N_PARTS];
+    uint8_t isPartVisible_[N_PARTS];
+
+    // Pièces et fenêtres visibles, reconstruites par cull().
+    DrawCommandBuffer commands_{GL_STREAM_DRAW};
+    DrawCommandRange partDraws_;
+    DrawCommandRange windowDraws_;
+    
 public:
     glm::mat4 carModel;
 
-    EdgeEffect* edgeEffectShader;
-    CelShading* celShadingShader;
-    UniformBuffer* material;
-
     glm::vec3 position;
     glm::vec2 orientation;    
     
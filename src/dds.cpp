@@ -0,0 +1,231 @@
+#include "dds.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static const uint32_t DDS_MAGIC = 0x20534444; // "DDS "
+
+static const uint32_t DDSD_CAPS        = 0x1;
+static const uint32_t DDSD_HEIGHT      = 0x2;
+static const uint32_t DDSD_WIDTH       = 0x4;
+static const uint32_t DDSD_PITCH       = 0x8;
+static const uint32_t DDSD_PIXELFORMAT = 0x1000;
+static const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+static const uint32_t DDSD_LINEARSIZE  = 0x80000;
+
+static const uint32_t DDPF_FOURCC = 0x4;
+
+static const uint32_t DDSCAPS_COMPLEX = 0x8;
+static const uint32_t DDSCAPS_TEXTURE = 0x1000;
+static const uint32_t DDSCAPS_MIPMAP  = 0x400000;
+
+static const uint32_t DXGI_FORMAT_R8G8B8A8_UNORM = 28;
+static const uint32_t DXGI_FORMAT_BC1_UNORM = 71;
+static const uint32_t DXGI_FORMAT_BC3_UNORM = 77;
+static const uint32_t DXGI_FORMAT_BC7_UNORM = 98;
+
+static const uint32_t D3D10_RESOURCE_DIMENSION_TEXTURE2D = 3;
+
+static constexpr uint32_t makeFourCC(char a, char b, char c, char d)
+{
+    return (uint32_t)(unsigned char)a | ((uint32_t)(unsigned char)b << 8)
+         | ((uint32_t)(unsigned char)c << 16) | ((uint32_t)(unsigned char)d << 24);
+}
+
+struct DdsPixelFormat
+{
+    uint32_t size;
+    uint32_t flags;
+    uint32_t fourCC;
+    uint32_t rgbBitCount;
+    uint32_t rBitMask;
+    uint32_t gBitMask;
+    uint32_t bBitMask;
+    uint32_t aBitMask;
+};
+
+struct DdsHeader
+{
+    uint32_t size;
+    uint32_t flags;
+    uint32_t height;
+    uint32_t width;
+    uint32_t pitchOrLinearSize;
+    uint32_t depth;
+    uint32_t mipMapCount;
+    uint32_t reserved1[11];
+    DdsPixelFormat pixelFormat;
+    uint32_t caps;
+    uint32_t caps2;
+    uint32_t caps3;
+    uint32_t caps4;
+    uint32_t reserved2;
+};
+
+struct DdsHeaderDx10
+{
+    uint32_t dxgiFormat;
+    uint32_t resourceDimension;
+    uint32_t miscFlag;
+    uint32_t arraySize;
+    uint32_t miscFlags2;
+};
+
+static_assert(sizeof(DdsHeader) == 124, "Invalid DDS header size");
+static_assert(sizeof(DdsHeaderDx10) == 20, "Invalid DDS DX10 header size");
+
+size_t getDdsBlockSize(DdsFormat format)
+{
+    return format == DdsFormat::BC1 ? 8 : 16;
+}
+
+size_t getDdsLevelSize(DdsFormat format, uint32_t width, uint32_t height)
+{
+    if (format == DdsFormat::RGBA8)
+        return (size_t)width * height * 4;
+
+    size_t blocksWide = std::max(1u, (width + 3) / 4);
+    size_t blocksHigh = std::max(1u, (height + 3) / 4);
+    return blocksWide * blocksHigh * getDdsBlockSize(format);
+}
+
+bool readDds(const char* path, DdsImage& image)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    uint32_t magic = 0;
+    DdsHeader header;
+    file.read((char*)&magic, sizeof(magic));
+    file.read((char*)&header, sizeof(header));
+    if (!file || magic != DDS_MAGIC || header.size != sizeof(DdsHeader))
+    {
+        std::cout << "Invalid DDS file \"" << path << "\"" << std::endl;
+        return false;
+    }
+
+    uint32_t fourCC = header.pixelFormat.fourCC;
+    if (!(header.pixelFormat.flags & DDPF_FOURCC))
+        fourCC = 0;
+
+    if (fourCC == makeFourCC('D', 'X', 'T', '1'))
+        image.format = DdsFormat::BC1;
+    else if (fourCC == makeFourCC('D', 'X', 'T', '5'))
+        image.format = DdsFormat::BC3;
+    else if (fourCC == makeFourCC('D', 'X', '1', '0'))
+    {
+        DdsHeaderDx10 headerDx10;
+        file.read((char*)&headerDx10, sizeof(headerDx10));
+        if (headerDx10.dxgiFormat == DXGI_FORMAT_BC1_UNORM)
+            image.format = DdsFormat::BC1;
+        else if (headerDx10.dxgiFormat == DXGI_FORMAT_BC3_UNORM)
+            image.format = DdsFormat::BC3;
+        else if (headerDx10.dxgiFormat == DXGI_FORMAT_BC7_UNORM)
+            image.format = DdsFormat::BC7;
+        else if (headerDx10.dxgiFormat == DXGI_FORMAT_R8G8B8A8_UNORM)
+            image.format = DdsFormat::RGBA8;
+        else
+        {
+            std::cout << "Unsupported DXGI format " << headerDx10.dxgiFormat << " in \"" << path << "\"" << std::endl;
+            return false;
+        }
+    }
+    else
+    {
+        std::cout << "Unsupported DDS pixel format in \"" << path << "\"" << std::endl;
+        return false;
+    }
+
+    image.width = header.width;
+    image.height = header.height;
+
+    uint32_t nLevels = std::max(1u, header.mipMapCount);
+    image.levels.resize(nLevels);
+    size_t totalSize = 0;
+    uint32_t width = image.width;
+    uint32_t height = image.height;
+    for (uint32_t i = 0; i < nLevels; i++)
+    {
+        size_t levelSize = getDdsLevelSize(image.format, width, height);
+        image.levels[i] = {width, height, totalSize, levelSize};
+        totalSize += levelSize;
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+    }
+
+    image.data.resize(totalSize);
+    file.read((char*)image.data.data(), totalSize);
+    if (!file)
+    {
+        std::cout << "Truncated DDS file \"" << path << "\"" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool writeDds(const char* path, const DdsImage& image)
+{
+    DdsHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.size = sizeof(DdsHeader);
+    header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT;
+    header.height = image.height;
+    header.width = image.width;
+    if (image.format == DdsFormat::RGBA8)
+    {
+        header.flags |= DDSD_PITCH;
+        header.pitchOrLinearSize = image.width * 4;
+    }
+    else
+    {
+        header.flags |= DDSD_LINEARSIZE;
+        header.pitchOrLinearSize = image.levels.empty() ? 0 : image.levels[0].size;
+    }
+    header.mipMapCount = image.levels.size();
+    header.pixelFormat.size = sizeof(DdsPixelFormat);
+    header.pixelFormat.flags = DDPF_FOURCC;
+    header.caps = DDSCAPS_TEXTURE;
+    if (image.levels.size() > 1)
+    {
+        header.flags |= DDSD_MIPMAPCOUNT;
+        header.caps |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+    }
+
+    bool needsDx10Header = false;
+    DdsHeaderDx10 headerDx10 = {0, D3D10_RESOURCE_DIMENSION_TEXTURE2D, 0, 1, 0};
+    switch (image.format)
+    {
+        case DdsFormat::BC1:
+            header.pixelFormat.fourCC = makeFourCC('D', 'X', 'T', '1');
+        break;
+        case DdsFormat::BC3:
+            header.pixelFormat.fourCC = makeFourCC('D', 'X', 'T', '5');
+        break;
+        case DdsFormat::BC7:
+            header.pixelFormat.fourCC = makeFourCC('D', 'X', '1', '0');
+            headerDx10.dxgiFormat = DXGI_FORMAT_BC7_UNORM;
+            needsDx10Header = true;
+        break;
+        case DdsFormat::RGBA8:
+            header.pixelFormat.fourCC = makeFourCC('D', 'X', '1', '0');
+            headerDx10.dxgiFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+            needsDx10Header = true;
+        break;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cout << "Could not write DDS file \"" << path << "\"" << std::endl;
+        return false;
+    }
+    file.write((const char*)&DDS_MAGIC, sizeof(DDS_MAGIC));
+    file.write((const char*)&header, sizeof(header));
+    if (needsDx10Header)
+        file.write((const char*)&headerDx10, sizeof(headerDx10));
+    file.write((const char*)image.data.data(), image.data.size());
+    return file.good();
+}
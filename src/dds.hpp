@@ -0,0 +1,44 @@
+#ifndef DDS_H
+#define DDS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <vector>
+
+// Lecture et écriture de conteneurs DDS. Ce module ne dépend pas d'OpenGL pour
+// être partagé avec l'outil de conversion hors ligne.
+
+enum class DdsFormat
+{
+    BC1,
+    BC3,
+    BC7,
+    RGBA8, // Non compressé, pour les textures où les artefacts de blocs se voient trop.
+};
+
+struct DdsLevel
+{
+    uint32_t width;
+    uint32_t height;
+    size_t offset;
+    size_t size;
+};
+
+struct DdsImage
+{
+    DdsFormat format;
+    uint32_t width;
+    uint32_t height;
+    std::vector<DdsLevel> levels;
+    std::vector<unsigned char> data;
+};
+
+// Taille d'un bloc 4x4, pour les formats compressés seulement.
+size_t getDdsBlockSize(DdsFormat format);
+size_t getDdsLevelSize(DdsFormat format, uint32_t width, uint32_t height);
+
+bool readDds(const char* path, DdsImage& image);
+bool writeDds(const char* path, const DdsImage& image);
+
+#endif // DDS_H
@@ -0,0 +1,122 @@
+#include "frustum_culling.hpp"
+
+#include <algorithm>
+#include <cfloat>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #define FRUSTUM_CULLING_SSE
+    #include <xmmintrin.h>
+#endif
+
+static_assert(sizeof(BoundingSphere) == 4 * sizeof(float), "Les sphères sont lues comme des vecteurs de 4 float");
+
+BoundingSphere transformSphere(const BoundingSphere& sphere, const glm::mat4& model)
+{
+    float scale = std::max(std::max(glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1]))),
+                           glm::length(glm::vec3(model[2])));
+    return {glm::vec3(model * glm::vec4(sphere.center, 1.0f)), sphere.radius * scale};
+}
+
+BoundingSphere enclosingSphere(const BoundingSphere* spheres, size_t count)
+{
+    glm::vec3 min(FLT_MAX);
+    glm::vec3 max(-FLT_MAX);
+    for (size_t i = 0; i < count; i++)
+    {
+        min = glm::min(min, spheres[i].center - spheres[i].radius);
+        max = glm::max(max, spheres[i].center + spheres[i].radius);
+    }
+
+    BoundingSphere enclosing = {(min + max) * 0.5f, 0.0f};
+    for (size_t i = 0; i < count; i++)
+        enclosing.radius = std::max(enclosing.radius, glm::length(spheres[i].center - enclosing.center) + spheres[i].radius);
+    return enclosing;
+}
+
+Frustum::Frustum(const glm::mat4& projView, bool hasNearPlane)
+{
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++)
+        rows[i] = glm::vec4(projView[0][i], projView[1][i], projView[2][i], projView[3][i]);
+
+    for (int i = 0; i < 3; i++)
+    {
+        planes_[2 * i] = rows[3] + rows[i];
+        planes_[2 * i + 1] = rows[3] - rows[i];
+    }
+    for (int i = 0; i < N_PLANES; i++)
+        planes_[i] = planes_[i] / glm::length(glm::vec3(planes_[i]));
+
+    // Plan qui laisse tout passer
+    const int NEAR_PLANE = 4;
+    if (!hasNearPlane)
+        planes_[NEAR_PLANE] = glm::vec4(0.0f, 0.0f, 0.0f, FLT_MAX);
+}
+
+bool Frustum::isVisible(const BoundingSphere& sphere) const
+{
+    for (int i = 0; i < N_PLANES; i++)
+    {
+        if (glm::dot(glm::vec3(planes_[i]), sphere.center) + planes_[i].w < -sphere.radius)
+            return false;
+    }
+    return true;
+}
+
+const glm::vec4* Frustum::getPlanes() const
+{
+    return planes_;
+}
+
+Frustum::Containment Frustum::testBox(const glm::vec3& min, const glm::vec3& max) const
+{
+    glm::vec3 center = 0.5f * (min + max);
+    glm::vec3 extent = 0.5f * (max - min);
+
+    Containment result = INSIDE;
+    for (int i = 0; i < N_PLANES; i++)
+    {
+        glm::vec3 normal(planes_[i]);
+        float distance = glm::dot(normal, center) + planes_[i].w;
+        float projectedExtent = glm::dot(glm::abs(normal), extent);
+        if (distance + projectedExtent < 0.0f)
+            return OUTSIDE;
+        if (distance - projectedExtent < 0.0f)
+            result = INTERSECTING;
+    }
+    return result;
+}
+
+void Frustum::cull(const BoundingSphere* spheres, size_t count, uint8_t* visible) const
+{
+    size_t i = 0;
+#ifdef FRUSTUM_CULLING_SSE
+    for (; i + 4 <= count; i += 4)
+    {
+        // 4 sphères (x, y, z, r) transposées en x[4], y[4], z[4], r[4]
+        __m128 x = _mm_loadu_ps(&spheres[i].center.x);
+        __m128 y = _mm_loadu_ps(&spheres[i + 1].center.x);
+        __m128 z = _mm_loadu_ps(&spheres[i + 2].center.x);
+        __m128 r = _mm_loadu_ps(&spheres[i + 3].center.x);
+        _MM_TRANSPOSE4_PS(x, y, z, r);
+        __m128 zero = _mm_setzero_ps();
+        __m128 negativeRadius = _mm_sub_ps(zero, r);
+
+        __m128 isInside = _mm_cmpeq_ps(zero, zero);
+        for (int p = 0; p < N_PLANES; p++)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(planes_[p].x)),
+                                                    _mm_mul_ps(y, _mm_set1_ps(planes_[p].y))),
+                                         _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(planes_[p].z)),
+                                                    _mm_set1_ps(planes_[p].w)));
+            isInside = _mm_and_ps(isInside, _mm_cmpge_ps(distance, negativeRadius));
+        }
+
+        int mask = _mm_movemask_ps(isInside);
+        for (int j = 0; j < 4; j++)
+            visible[i + j] = (mask >> j) & 1;
+    }
+#endif
+    for (; i < count; i++)
+        visible[i] = isVisible(spheres[i]);
+}
@@ -0,0 +1,47 @@
+#ifndef FRUSTUM_CULLING_H
+#define FRUSTUM_CULLING_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "model.hpp"
+
+// Sphère englobante du maillage placé par la matrice modèle donnée.
+BoundingSphere transformSphere(const BoundingSphere& sphere, const glm::mat4& model);
+// Sphère qui contient toutes les sphères données, centrée sur leur boîte englobante.
+BoundingSphere enclosingSphere(const BoundingSphere* spheres, size_t count);
+
+// Volume de vue sous forme de 6 plans, extraits d'une matrice projection * vue.
+class Frustum
+{
+public:
+    // Sans plan proche, tout ce qui est devant le volume est gardé (cartes
+    // d'ombres dessinées avec GL_DEPTH_CLAMP).
+    explicit Frustum(const glm::mat4& projView, bool hasNearPlane = true);
+
+    enum Containment
+    {
+        OUTSIDE,
+        INTERSECTING,
+        INSIDE
+    };
+
+    bool isVisible(const BoundingSphere& sphere) const;
+    Containment testBox(const glm::vec3& min, const glm::vec3& max) const;
+
+    // visible[i] = 1 si la sphère i touche le volume, 0 sinon. Les sphères sont
+    // testées 4 à la fois contre chaque plan quand SSE est disponible.
+    void cull(const BoundingSphere* spheres, size_t count, uint8_t* visible) const;
+
+    // Plans: gauche, droite, bas, haut, proche, lointain.
+    static constexpr int N_PLANES = 6;
+    const glm::vec4* getPlanes() const;
+
+private:
+    // Normales vers l'intérieur, normalisées: (a, b, c, d), d = distance.
+    glm::vec4 planes_[N_PLANES];
+};
+
+#endif // FRUSTUM_CULLING_H
@@ -0,0 +1,202 @@
+#include "geometry_pool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+
+const GLuint VERTEX_POSITION_INDEX = 0;
+const GLuint VERTEX_COLOR_INDEX = 1;
+const GLuint VERTEX_NORMAL_INDEX = 2;
+const GLuint VERTEX_TEXCOORDS_INDEX = 3;
+
+GeometryPool::GeometryPool()
+: vao_(0), vbo_(0), ebo_(0), instanceIndexVbo_(0), instanceCapacity_(0)
+, vertexCapacity_(0), indexCapacity_(0)
+, nVertices_(0), nIndices_(0)
+{
+}
+
+GeometryPool::~GeometryPool()
+{
+    glDeleteVertexArrays(1, &vao_);
+    glDeleteBuffers(1, &vbo_);
+    glDeleteBuffers(1, &ebo_);
+    glDeleteBuffers(1, &instanceIndexVbo_);
+}
+
+void GeometryPool::allocate(size_t vertexCapacity, size_t indexCapacity)
+{
+    glGenVertexArrays(1, &vao_);
+    instanceCapacity_ = INITIAL_INSTANCES;
+    setupInstanceIndexes();
+    grow(vertexCapacity, indexCapacity);
+}
+
+void GeometryPool::reserveInstances(GLuint nInstances)
+{
+    if (nInstances <= instanceCapacity_)
+        return;
+
+    instanceCapacity_ = std::max(nInstances, instanceCapacity_ * 2);
+    setupInstanceIndexes();
+}
+
+MeshRange GeometryPool::addMesh(const VertexModel* vertices, size_t nVertices, const unsigned int* elements, size_t nElements)
+{
+    if (nVertices_ + nVertices > vertexCapacity_ || nIndices_ + nElements > indexCapacity_)
+    {
+        grow(std::max(vertexCapacity_ * 2, nVertices_ + nVertices),
+             std::max(indexCapacity_ * 2, nIndices_ + nElements));
+    }
+
+    MeshRange mesh = {(GLuint)nIndices_, (GLsizei)nElements, (GLint)nVertices_};
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBufferSubData(GL_ARRAY_BUFFER, nVertices_ * sizeof(VertexModel), nVertices * sizeof(VertexModel), vertices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ebo_);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, nIndices_ * sizeof(GLuint), nElements * sizeof(GLuint), elements);
+
+    nVertices_ += nVertices;
+    nIndices_ += nElements;
+    return mesh;
+}
+
+void GeometryPool::bind()
+{
+    glBindVertexArray(vao_);
+}
+
+void GeometryPool::grow(size_t vertexCapacity, size_t indexCapacity)
+{
+    // Les tampons d'indices passent par GL_COPY_WRITE_BUFFER pour ne pas
+    // modifier le GL_ELEMENT_ARRAY_BUFFER d'un VAO lié.
+    GLuint buffers[2];
+    glGenBuffers(2, buffers);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[0]);
+    glBufferData(GL_COPY_WRITE_BUFFER, vertexCapacity * sizeof(VertexModel), nullptr, GL_STATIC_DRAW);
+    if (vbo_)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, vbo_);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, nVertices_ * sizeof(VertexModel));
+        glDeleteBuffers(1, &vbo_);
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[1]);
+    glBufferData(GL_COPY_WRITE_BUFFER, indexCapacity * sizeof(GLuint), nullptr, GL_STATIC_DRAW);
+    if (ebo_)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, ebo_);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, nIndices_ * sizeof(GLuint));
+        glDeleteBuffers(1, &ebo_);
+    }
+
+    vbo_ = buffers[0];
+    ebo_ = buffers[1];
+    vertexCapacity_ = vertexCapacity;
+    indexCapacity_ = indexCapacity;
+    setupVertexArray();
+}
+
+void GeometryPool::setupInstanceIndexes()
+{
+    // Tampon 0, 1, 2, ... : avec un diviseur de 1, l'attribut vaut
+    // gl_InstanceID + baseInstance, soit l'indice de l'instance dans InstanceBlock.
+    std::vector<GLuint> indexes(instanceCapacity_);
+    std::iota(indexes.begin(), indexes.end(), 0);
+    glDeleteBuffers(1, &instanceIndexVbo_);
+    glGenBuffers(1, &instanceIndexVbo_);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceIndexVbo_);
+    glBufferData(GL_ARRAY_BUFFER, indexes.size() * sizeof(GLuint), indexes.data(), GL_STATIC_DRAW);
+
+    glBindVertexArray(vao_);
+    glEnableVertexAttribArray(INSTANCE_INDEX_ATTRIBUTE);
+    glVertexAttribIPointer(INSTANCE_INDEX_ATTRIBUTE, 1, GL_UNSIGNED_INT, sizeof(GLuint), (GLvoid*)0);
+    glVertexAttribDivisor(INSTANCE_INDEX_ATTRIBUTE, 1);
+    glBindVertexArray(0);
+}
+
+void GeometryPool::setupVertexArray()
+{
+    glBindVertexArray(vao_);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+
+    // Les maillages sans normales ou coordonnées de texture ont des zéros à la place.
+    glEnableVertexAttribArray(VERTEX_POSITION_INDEX);
+    glVertexAttribPointer(VERTEX_POSITION_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(VertexModel), (GLvoid*)(offsetof(VertexModel, pos)));
+
+    glEnableVertexAttribArray(VERTEX_COLOR_INDEX);
+    glVertexAttribPointer(VERTEX_COLOR_INDEX, 3, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(VertexModel), (GLvoid*)(offsetof(VertexModel, color)));
+
+    glEnableVertexAttribArray(VERTEX_NORMAL_INDEX);
+    glVertexAttribPointer(VERTEX_NORMAL_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(VertexModel), (GLvoid*)(offsetof(VertexModel, normal)));
+
+    glEnableVertexAttribArray(VERTEX_TEXCOORDS_INDEX);
+    glVertexAttribPointer(VERTEX_TEXCOORDS_INDEX, 2, GL_FLOAT, GL_FALSE, sizeof(VertexModel), (GLvoid*)(offsetof(VertexModel, texCoord)));
+
+    glBindVertexArray(0);
+}
+
+
+DrawCommandBuffer::DrawCommandBuffer(GLenum usage)
+: id_(0), usage_(usage), groupStart_(0)
+{
+}
+
+DrawCommandBuffer::~DrawCommandBuffer()
+{
+    glDeleteBuffers(1, &id_);
+}
+
+void DrawCommandBuffer::clear()
+{
+    commands_.clear();
+    groupStart_ = 0;
+}
+
+void DrawCommandBuffer::add(const Model& model, const InstanceRange& instances)
+{
+    const MeshRange& mesh = model.mesh();
+    commands_.push_back({(GLuint)mesh.count, (GLuint)instances.count, mesh.firstIndex, mesh.baseVertex, instances.first});
+}
+
+void DrawCommandBuffer::addVisible(const Model& model, const InstanceRange& instances, const uint8_t* isInstanceVisible)
+{
+    GLuint end = instances.first + instances.count;
+    GLuint i = instances.first;
+    while (i < end)
+    {
+        while (i < end && !isInstanceVisible[i])
+            i++;
+        GLuint runStart = i;
+        while (i < end && isInstanceVisible[i])
+            i++;
+        if (i > runStart)
+            add(model, {runStart, (GLsizei)(i - runStart)});
+    }
+}
+
+DrawCommandRange DrawCommandBuffer::endGroup()
+{
+    DrawCommandRange range = {groupStart_, (GLsizei)(commands_.size() - groupStart_)};
+    groupStart_ = commands_.size();
+    return range;
+}
+
+void DrawCommandBuffer::upload()
+{
+    if (!id_)
+        glGenBuffers(1, &id_);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, id_);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, commands_.size() * sizeof(DrawElementsIndirectCommand), commands_.data(), usage_);
+}
+
+void DrawCommandBuffer::draw(const DrawCommandRange& range)
+{
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, id_);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                (GLvoid*)(range.first * sizeof(DrawElementsIndirectCommand)),
+                                range.count, 0);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glbinding/gl/gl.h>
+
+#include "model.hpp"
+
+using namespace gl;
+
+// Tampons de sommets et d'indices partagés par tous les modèles, avec un seul VAO.
+// Les maillages y sont sous-alloués les uns à la suite des autres; les tampons
+// doublent de taille lorsqu'ils sont pleins.
+class GeometryPool
+{
+public:
+    // Capacité initiale du tampon d'indices d'instances.
+    static constexpr GLuint INITIAL_INSTANCES = 65536;
+    static constexpr GLuint INSTANCE_INDEX_ATTRIBUTE = 4;
+
+    GeometryPool();
+    ~GeometryPool();
+
+    void allocate(size_t vertexCapacity, size_t indexCapacity);
+
+    MeshRange addMesh(const VertexModel* vertices, size_t nVertices, const unsigned int* elements, size_t nElements);
+
+    // Agrandit le tampon d'indices d'instances pour couvrir [0, nInstances).
+    void reserveInstances(GLuint nInstances);
+
+    // Une fois par passe, avant les dessins des modèles et des commandes.
+    void bind();
+
+private:
+    void grow(size_t vertexCapacity, size_t indexCapacity);
+    void setupInstanceIndexes();
+    void setupVertexArray();
+
+private:
+    GLuint vao_, vbo_, ebo_;
+    GLuint instanceIndexVbo_;
+    GLuint instanceCapacity_;
+    size_t vertexCapacity_, indexCapacity_;
+    size_t nVertices_, nIndices_;
+};
+
+// Doit correspondre à la structure attendue par glMultiDrawElementsIndirect.
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+struct DrawCommandRange
+{
+    GLuint first;
+    GLsizei count;
+};
+
+// Commandes de dessin indirect regroupées par état de rendu. Chaque groupe est
+// soumis en un seul glMultiDrawElementsIndirect.
+class DrawCommandBuffer
+{
+public:
+    // GL_STREAM_DRAW pour des commandes reconstruites à chaque image.
+    DrawCommandBuffer(GLenum usage = GL_STATIC_DRAW);
+    ~DrawCommandBuffer();
+
+    void clear();
+    void add(const Model& model, const InstanceRange& instances);
+    // Une commande par suite d'instances visibles; isInstanceVisible est indexé
+    // par l'indice absolu de l'instance.
+    void addVisible(const Model& model, const InstanceRange& instances, const uint8_t* isInstanceVisible);
+    // Termine le groupe formé des commandes ajoutées depuis le dernier appel.
+    DrawCommandRange endGroup();
+
+    void upload();
+
+    // Le VAO de GeometryPool doit être lié.
+    void draw(const DrawCommandRange& range);
+
+private:
+    GLuint id_;
+    GLenum usage_;
+    std::vector<DrawElementsIndirectCommand> commands_;
+    GLuint groupStart_;
+};
@@ -0,0 +1,52 @@
+#include "gpu_timer.hpp"
+
+GpuTimer::GpuTimer()
+: query_(0), isPending_(false), isMeasuring_(false), lastTime_(0.0f)
+{
+}
+
+GpuTimer::~GpuTimer()
+{
+    glDeleteQueries(1, &query_);
+}
+
+void GpuTimer::begin()
+{
+    if (!query_)
+        glGenQueries(1, &query_);
+
+    pollResult();
+    isMeasuring_ = !isPending_;
+    if (isMeasuring_)
+        glBeginQuery(GL_TIME_ELAPSED, query_);
+}
+
+void GpuTimer::end()
+{
+    if (!isMeasuring_)
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    isMeasuring_ = false;
+    isPending_ = true;
+}
+
+float GpuTimer::getLastTime() const
+{
+    return lastTime_;
+}
+
+void GpuTimer::pollResult()
+{
+    if (!isPending_)
+        return;
+
+    GLuint isAvailable = 0;
+    glGetQueryObjectuiv(query_, GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+    if (isAvailable)
+    {
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(query_, GL_QUERY_RESULT, &elapsed);
+        lastTime_ = elapsed * 1e-6f;
+        isPending_ = false;
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <glbinding/gl/gl.h>
+
+using namespace gl;
+
+// Mesure la durée GPU des commandes entre begin() et end() avec une requête
+// GL_TIME_ELAPSED. Le résultat n'est lu que lorsqu'il est disponible, sans
+// attendre le GPU; les intervalles commencés entre-temps ne sont pas mesurés.
+class GpuTimer
+{
+public:
+    GpuTimer();
+    ~GpuTimer();
+
+    void begin();
+    void end();
+
+    // Dernière durée mesurée, en millisecondes.
+    float getLastTime() const;
+
+private:
+    void pollResult();
+
+private:
+    GLuint query_;
+    bool isPending_;
+    bool isMeasuring_;
+    float lastTime_;
+};
+
+#endif // GPU_TIMER_H
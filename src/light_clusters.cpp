@@ -0,0 +1,44 @@
+#include "light_clusters.hpp"
+
+#include <cmath>
+
+#include <glm/gtc/type_ptr.hpp>
+
+void LightClusters::init(GLuint bindingIndex)
+{
+    clusters_.allocate(nullptr, N_CLUSTERS * (MAX_LIGHTS_PER_CLUSTER + 1) * sizeof(GLuint), GL_DYNAMIC_COPY);
+    clusters_.setBindingIndex(bindingIndex);
+    shader_.create();
+}
+
+void LightClusters::reloadShader()
+{
+    shader_.create();
+}
+
+void LightClusters::update(const glm::mat4& view, const glm::mat4& projection, float zNear, float zFar, int nSpotLights)
+{
+    zNear_ = zNear;
+    zFar_ = zFar;
+
+    shader_.use();
+    glUniformMatrix4fv(shader_.viewULoc, 1, GL_FALSE, glm::value_ptr(view));
+    glUniform1i(shader_.nSpotLightsULoc, nSpotLights);
+    glUniform3ui(shader_.clusterGridSizeULoc, GRID_SIZE_X, GRID_SIZE_Y, GRID_SIZE_Z);
+    glUniform2f(shader_.projScaleULoc, projection[0][0], projection[1][1]);
+    glUniform1f(shader_.zNearULoc, zNear);
+    glUniform1f(shader_.zFarULoc, zFar);
+
+    glDispatchCompute((N_CLUSTERS + 63) / 64, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void LightClusters::setShaderUniforms(CelShading& shader, glm::vec2 viewportSize)
+{
+    float depthScale = GRID_SIZE_Z / std::log(zFar_ / zNear_);
+    float depthBias = depthScale * std::log(zNear_);
+
+    glUniform3ui(shader.clusterGridSizeULoc, GRID_SIZE_X, GRID_SIZE_Y, GRID_SIZE_Z);
+    glUniform2f(shader.clusterTileSizeULoc, viewportSize.x / GRID_SIZE_X, viewportSize.y / GRID_SIZE_Y);
+    glUniform2f(shader.clusterDepthParamsULoc, depthScale, depthBias);
+}
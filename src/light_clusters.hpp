@@ -0,0 +1,43 @@
+#ifndef LIGHT_CLUSTERS_H
+#define LIGHT_CLUSTERS_H
+
+#include <glbinding/gl/gl.h>
+#include <glm/glm.hpp>
+
+#include "shaders.hpp"
+#include "shader_storage_buffer.hpp"
+
+using namespace gl;
+
+// Grille de lumières forward+: l'écran est découpé en tuiles, et la profondeur
+// en tranches exponentielles. Un nuanceur de calcul range chaque lumière dans
+// les grappes que sa sphère d'influence touche, puis phong.fs n'évalue que les
+// lumières de la grappe du fragment.
+class LightClusters
+{
+public:
+    static constexpr GLuint GRID_SIZE_X = 16;
+    static constexpr GLuint GRID_SIZE_Y = 9;
+    static constexpr GLuint GRID_SIZE_Z = 24;
+    static constexpr GLuint N_CLUSTERS = GRID_SIZE_X * GRID_SIZE_Y * GRID_SIZE_Z;
+    // Doit correspondre à MAX_LIGHTS_PER_CLUSTER des nuanceurs.
+    static constexpr GLuint MAX_LIGHTS_PER_CLUSTER = 32;
+    // Portée des lumières, doit correspondre à LIGHT_RADIUS des nuanceurs.
+    static constexpr float LIGHT_RADIUS = 10.0f;
+
+    void init(GLuint bindingIndex);
+    void reloadShader();
+
+    // À appeler une fois par image, avant les dessins éclairés.
+    void update(const glm::mat4& view, const glm::mat4& projection, float zNear, float zFar, int nSpotLights);
+
+    void setShaderUniforms(CelShading& shader, glm::vec2 viewportSize);
+
+private:
+    LightClusterShader shader_;
+    ShaderStorageBuffer clusters_;
+    float zNear_;
+    float zFar_;
+};
+
+#endif // LIGHT_CLUSTERS_H
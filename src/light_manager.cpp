@@ -0,0 +1,191 @@
+#include "light_manager.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static const GLuint INVALID_INDEX = ~0u;
+// Écart maximal, en lumières, entre deux plages modifiées envoyées d'un seul appel.
+// Renvoyer quelques lumières inchangées coûte moins cher qu'un appel de plus.
+static const GLuint MAX_COALESCE_GAP = 2;
+
+static bool isSameLight(const SpotLight& a, const SpotLight& b)
+{
+    return std::memcmp(&a, &b, sizeof(SpotLight)) == 0;
+}
+
+LightManager::LightManager()
+: id_(0), bindingIndex_(0), capacity_(0)
+, dirtyBegin_(0), dirtyEnd_(0), lastUploadCount_(0)
+{
+}
+
+LightManager::~LightManager()
+{
+    glDeleteBuffers(1, &id_);
+}
+
+void LightManager::allocate(GLuint initialCapacity)
+{
+    capacity_ = std::max(initialCapacity, 1u);
+    glGenBuffers(1, &id_);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, id_);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, capacity_ * sizeof(SpotLight), nullptr, GL_DYNAMIC_DRAW);
+}
+
+void LightManager::setBindingIndex(GLuint index)
+{
+    bindingIndex_ = index;
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bindingIndex_, id_);
+}
+
+LightManager::LightHandle LightManager::addSpotLight(const SpotLight& light)
+{
+    LightHandle handle;
+    if (!freeHandles_.empty())
+    {
+        handle = freeHandles_.back();
+        freeHandles_.pop_back();
+    }
+    else
+    {
+        handle = handleToIndex_.size();
+        handleToIndex_.push_back(INVALID_INDEX);
+    }
+
+    handleToIndex_[handle] = lights_.size();
+    indexToHandle_.push_back(handle);
+    lights_.push_back(light);
+    markDirty(lights_.size() - 1);
+    return handle;
+}
+
+void LightManager::removeSpotLight(LightHandle handle)
+{
+    if (!isValid(handle))
+    {
+        std::cout << "Invalid light handle: " << handle << std::endl;
+        return;
+    }
+
+    GLuint index = handleToIndex_[handle];
+    GLuint last = lights_.size() - 1;
+    if (index != last)
+    {
+        lights_[index] = lights_[last];
+        indexToHandle_[index] = indexToHandle_[last];
+        handleToIndex_[indexToHandle_[index]] = index;
+        markDirty(index);
+    }
+    lights_.pop_back();
+    indexToHandle_.pop_back();
+
+    handleToIndex_[handle] = INVALID_INDEX;
+    freeHandles_.push_back(handle);
+}
+
+void LightManager::updateSpotLight(LightHandle handle, const SpotLight& light)
+{
+    if (!isValid(handle))
+    {
+        std::cout << "Invalid light handle: " << handle << std::endl;
+        return;
+    }
+
+    GLuint index = handleToIndex_[handle];
+    if (isSameLight(lights_[index], light))
+        return;
+    lights_[index] = light;
+    markDirty(index);
+}
+
+const SpotLight& LightManager::getSpotLight(LightHandle handle) const
+{
+    return lights_[handleToIndex_[handle]];
+}
+
+GLuint LightManager::getSpotLightCount() const
+{
+    return lights_.size();
+}
+
+void LightManager::upload()
+{
+    lastUploadCount_ = 0;
+
+    if (lights_.size() > capacity_)
+    {
+        while (capacity_ < lights_.size())
+            capacity_ *= 2;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, id_);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, capacity_ * sizeof(SpotLight), nullptr, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bindingIndex_, id_);
+
+        // Le nouveau tampon est vide: tout renvoyer.
+        uploaded_.clear();
+        dirtyBegin_ = 0;
+        dirtyEnd_ = lights_.size();
+    }
+
+    // Les lumières retirées à la fin n'ont pas à être envoyées.
+    dirtyEnd_ = std::min<GLuint>(dirtyEnd_, lights_.size());
+
+    GLuint nUploaded = uploaded_.size();
+    uploaded_.resize(lights_.size());
+
+    GLuint runBegin = INVALID_INDEX;
+    GLuint runEnd = 0;
+    for (GLuint i = dirtyBegin_; i < dirtyEnd_; i++)
+    {
+        if (i < nUploaded && isSameLight(lights_[i], uploaded_[i]))
+            continue;
+
+        if (runBegin != INVALID_INDEX && i - runEnd <= MAX_COALESCE_GAP)
+        {
+            runEnd = i + 1;
+            continue;
+        }
+        if (runBegin != INVALID_INDEX)
+            uploadRange(runBegin, runEnd);
+        runBegin = i;
+        runEnd = i + 1;
+    }
+    if (runBegin != INVALID_INDEX)
+        uploadRange(runBegin, runEnd);
+
+    dirtyBegin_ = 0;
+    dirtyEnd_ = 0;
+}
+
+GLuint LightManager::getLastUploadCount() const
+{
+    return lastUploadCount_;
+}
+
+bool LightManager::isValid(LightHandle handle) const
+{
+    return handle < handleToIndex_.size() && handleToIndex_[handle] != INVALID_INDEX;
+}
+
+void LightManager::markDirty(GLuint index)
+{
+    if (dirtyBegin_ == dirtyEnd_)
+    {
+        dirtyBegin_ = index;
+        dirtyEnd_ = index + 1;
+    }
+    else
+    {
+        dirtyBegin_ = std::min(dirtyBegin_, index);
+        dirtyEnd_ = std::max(dirtyEnd_, index + 1);
+    }
+}
+
+void LightManager::uploadRange(GLuint begin, GLuint end)
+{
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, id_);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, begin * sizeof(SpotLight),
+                    (end - begin) * sizeof(SpotLight), &lights_[begin]);
+    std::copy(lights_.begin() + begin, lights_.begin() + end, uploaded_.begin() + begin);
+    lastUploadCount_++;
+}
@@ -0,0 +1,88 @@
+#ifndef LIGHT_MANAGER_H
+#define LIGHT_MANAGER_H
+
+#include <vector>
+
+#include <glbinding/gl/gl.h>
+#include <glm/glm.hpp>
+
+using namespace gl;
+
+struct DirectionalLight
+{
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec4 specular;    
+    glm::vec4 direction;
+};
+
+// Disposition std430 de SpotLight dans SpotLightBlock.
+struct SpotLight
+{
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec4 specular;
+    
+    glm::vec4 position;
+    glm::vec3 direction;
+    GLfloat exponent;
+    GLfloat openingAngle;
+    // Tuile de l'atlas d'ombres, -1 sans ombre
+    GLint shadowMapIndex;
+    
+    GLfloat padding[2];
+};
+
+// Liste de projecteurs de taille variable, lue par les nuanceurs dans le tampon
+// SpotLightBlock. Les lumières restent contiguës: en retirer une déplace la
+// dernière à sa place. Les poignées, elles, ne changent pas.
+class LightManager
+{
+public:
+    typedef GLuint LightHandle;
+
+    LightManager();
+    ~LightManager();
+
+    void allocate(GLuint initialCapacity);
+    void setBindingIndex(GLuint index);
+
+    LightHandle addSpotLight(const SpotLight& light);
+    void removeSpotLight(LightHandle handle);
+    void updateSpotLight(LightHandle handle, const SpotLight& light);
+    const SpotLight& getSpotLight(LightHandle handle) const;
+
+    GLuint getSpotLightCount() const;
+
+    // Envoie les lumières modifiées depuis le dernier appel, en agrandissant
+    // le tampon au besoin. Les lumières identiques à la dernière copie envoyée
+    // sont sautées, et les plages voisines sont regroupées.
+    void upload();
+
+    // Nombre d'appels glBufferSubData du dernier upload().
+    GLuint getLastUploadCount() const;
+
+private:
+    bool isValid(LightHandle handle) const;
+    void markDirty(GLuint index);
+    void uploadRange(GLuint begin, GLuint end);
+
+private:
+    GLuint id_;
+    GLuint bindingIndex_;
+    GLuint capacity_;
+
+    std::vector<SpotLight> lights_;
+    // Contenu du tampon, tel que connu du CPU
+    std::vector<SpotLight> uploaded_;
+    std::vector<LightHandle> indexToHandle_;
+    std::vector<GLuint> handleToIndex_;
+    std::vector<LightHandle> freeHandles_;
+
+    // Intervalle [dirtyBegin_, dirtyEnd_) des lumières à envoyer.
+    GLuint dirtyBegin_;
+    GLuint dirtyEnd_;
+    GLuint lastUploadCount_;
+};
+
+#endif // LIGHT_MANAGER_H
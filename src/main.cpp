@@ -20,12 +20,28 @@
 
 #include <inf2705/OpenGLApplication.hpp>
 
+#include "asset_loader.hpp"
+#include "frustum_culling.hpp"
+#include "geometry_pool.hpp"
+#include "light_clusters.hpp"
+#include "light_manager.hpp"
+#include "occlusion_culling.hpp"
+#include "outline_pass.hpp"
+#include "particle_system.hpp"
+#include "transparency_pass.hpp"
+#include "soft_particle_pass.hpp"
+#include "shadow_maps.hpp"
+#include "static_bvh.hpp"
 #include "model.hpp"
 #include "car.hpp"
 
+#include "material.hpp"
 #include "model_data.hpp"
 #include "shaders.hpp"
+#include "shaders/depth.h"
 #include "textures.hpp"
+#include "texture_streamer.hpp"
+#include "transform_buffer.hpp"
 #include "uniform_buffer.hpp"
 #include "shader_storage_buffer.hpp"
 
@@ -34,44 +50,16 @@
 using namespace gl;
 using namespace glm;
 
-struct Material
-{
-    glm::vec4 emission;
-    glm::vec4 ambient;
-    glm::vec4 diffuse;
-    glm::vec3 specular;
-    GLfloat shininess;
-};
-
-struct DirectionalLight
-{
-    glm::vec4 ambient;
-    glm::vec4 diffuse;
-    glm::vec4 specular;    
-    glm::vec4 direction;
-};
-
-struct SpotLight
-{
-    glm::vec4 ambient;
-    glm::vec4 diffuse;
-    glm::vec4 specular;
-    
-    glm::vec4 position;
-    glm::vec3 direction;
-    GLfloat exponent;
-    GLfloat openingAngle;
-    
-    GLfloat padding[3];
-};
-
 Material defaultMat = 
 {
     {0.0f, 0.0f, 0.0f, 0.0f},
     {1.0f, 1.0f, 1.0f, 0.0f},
     {1.0f, 1.0f, 1.0f, 0.0f},
     {0.7f, 0.7f, 0.7f},
-    10.0f
+    10.0f,
+    LAYER_CAR,
+    true,
+    0.0f
 };
 
 Material grassMat = 
@@ -80,7 +68,10 @@ Material grassMat =
     {0.8f, 0.8f, 0.8f, 0.0f},
     {1.0f, 1.0f, 1.0f, 0.0f},
     {0.05f, 0.05f, 0.05f},
-    100.0f
+    100.0f,
+    LAYER_GRASS,
+    false,
+    0.0f
 };
 
 Material streetMat = 
@@ -89,7 +80,34 @@ Material streetMat =
     {0.7f, 0.7f, 0.7f, 0.0f},
     {1.0f, 1.0f, 1.0f, 0.0f},
     {0.025f, 0.025f, 0.025f},
-    300.0f
+    300.0f,
+    LAYER_STREET,
+    false,
+    -1.0f
+};
+
+Material streetcornerMat = 
+{
+    {0.0f, 0.0f, 0.0f, 0.0f},
+    {0.7f, 0.7f, 0.7f, 0.0f},
+    {1.0f, 1.0f, 1.0f, 0.0f},
+    {0.025f, 0.025f, 0.025f},
+    300.0f,
+    LAYER_STREETCORNER,
+    true,
+    0.0f
+};
+
+Material treeMat = 
+{
+    {0.0f, 0.0f, 0.0f, 0.0f},
+    {0.8f, 0.8f, 0.8f, 0.0f},
+    {1.0f, 1.0f, 1.0f, 0.0f},
+    {0.05f, 0.05f, 0.05f},
+    100.0f,
+    LAYER_PINE,
+    false,
+    0.0f
 };
 
 Material streetlightMat = 
@@ -98,7 +116,10 @@ Material streetlightMat =
     {0.8f, 0.8f, 0.8f, 0.0f},
     {1.0f, 1.0f, 1.0f, 0.0f},
     {0.7f, 0.7f, 0.7f},
-    10.0f
+    10.0f,
+    LAYER_STREETLIGHT,
+    false,
+    0.0f
 };
 
 Material streetlightLightMat = 
@@ -107,7 +128,10 @@ Material streetlightLightMat =
     {1.0f, 1.0f, 1.0f, 0.0f},
     {1.0f, 1.0f, 1.0f, 0.0f},
     {0.7f, 0.7f, 0.7f},
-    10.0f
+    10.0f,
+    LAYER_STREETLIGHT,
+    false,
+    0.0f
 };
 
 Material windowMat = 
@@ -116,7 +140,10 @@ Material windowMat =
     {1.0f, 1.0f, 1.0f, 0.0f},
     {1.0f, 1.0f, 1.0f, 0.0f},
     {1.0f, 1.0f, 1.0f},
-    2.0f
+    2.0f,
+    LAYER_WINDOW,
+    true,
+    0.0f
 };
 
 Material bezierMat = 
@@ -125,7 +152,24 @@ Material bezierMat =
     {0.0f, 0.0f, 0.0f, 0.0f},
     {0.0f, 0.0f, 0.0f, 0.0f},
     {0.0f, 0.0f, 0.0f},
-    1.0f
+    1.0f,
+    LAYER_GRASS,
+    false,
+    0.0f
+};
+
+// Indices des matériaux dans le tampon materialTable_ lu par les objets instanciés.
+enum MaterialIndex : GLuint
+{
+    MATERIAL_GRASS,
+    MATERIAL_STREET,
+    MATERIAL_STREETCORNER,
+    MATERIAL_TREE,
+    MATERIAL_STREETLIGHT,
+    MATERIAL_STREETLIGHT_LIGHT,
+    // Suivi des Car::N_MATERIALS matériaux de la voiture
+    MATERIAL_CAR,
+    N_MATERIALS = MATERIAL_CAR + Car::N_MATERIALS
 };
 
 struct BezierCurve
@@ -171,17 +215,6 @@ BezierCurve curves[5] =
 };
 
 
-struct Particle
-{
-    glm::vec3 position;
-    GLfloat zOrientation;
-    glm::vec4 velocity;
-    glm::vec4 color;
-    glm::vec2 size; 
-    GLfloat timeToLive;
-    GLfloat maxTimeToLive;
-};
-
 struct Pos
 {
     GLfloat x;
@@ -213,9 +246,6 @@ struct App : public OpenGLApplication
     , currentScene_(0)
     , isMouseMotionEnabled_(false)
     , isDay_(false)
-    , totalTime(0.0)       
-    , timerParticles_(0.0) 
-    , nParticles_(0)
     {
     }
 	
@@ -233,8 +263,16 @@ struct App : public OpenGLApplication
 			"Flèches : tourner la caméra." "\n"
 			"Souris : tourner la caméra" "\n"
 			"Espace : activer/désactiver la souris." "\n"
+			"Clic gauche : sélectionner un objet, souris désactivée." "\n"
 		);
 
+        textureStreamer_.init();
+        loadTextures(assetLoader_);
+
+        geometryPool_.allocate(GEOMETRY_POOL_VERTICES, GEOMETRY_POOL_INDICES);
+        Model::setGeometryPool(&geometryPool_);
+        loadModels(assetLoader_);
+
         glGenVertexArrays(1, &vaoBezier_);
         glGenBuffers(1, &vboBezier_);
         
@@ -282,113 +320,34 @@ struct App : public OpenGLApplication
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
         glBindVertexArray(0);
         
-        std::vector<Particle> initialParticles(MAX_PARTICLES_, Particle{});
-        particles_[0].allocate(initialParticles.data(), MAX_PARTICLES_ * sizeof(Particle), GL_DYNAMIC_DRAW);
-        particles_[1].allocate(nullptr, MAX_PARTICLES_ * sizeof(Particle), GL_DYNAMIC_DRAW);
-        
-        glGenVertexArrays(1, &vaoParticles_);
-        glBindVertexArray(vaoParticles_);
-        particles_[0].bindAsArray();
-            
-        GLsizei stride = sizeof(Particle);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Particle, position));
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Particle, zOrientation));
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Particle, velocity));
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Particle, color));
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Particle, size));
-        glEnableVertexAttribArray(5);
-        glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Particle, timeToLive));
-        glEnableVertexAttribArray(6);
-        glVertexAttribPointer(6, 1, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Particle, maxTimeToLive));
-        glBindVertexArray(0);
+        particles_.init(MAX_PARTICLES);
+        exhaustEmitter_ = particles_.addEmitter();
 
-        particleComputeShader_.create();
-        particleDrawShader_.create(); 
+        for (auto& shaders : particleDrawShaders_)
+            for (ParticleDrawShader* shader : shaders)
+                shader->create();
         
-        smokeTexture_.load("../textures/smoke.png");
-        smokeTexture_.setWrap(GL_CLAMP_TO_EDGE);
-        smokeTexture_.setFiltering(GL_LINEAR);
-
         glClearColor(0.8f, 0.8f, 0.8f, 1.0f);
         glEnable(GL_DEPTH_TEST);
         glEnable(GL_CULL_FACE);
         
-        edgeEffectShader_.create();
+        outlinePass_.init();
+        transparencyPass_.init();
+        softParticlePass_.init();
+        transparentCelShadingShader_.create();
         celShadingShader_.create();
+        instancedCelShadingShader_.create();
         skyShader_.create();
         grassShader_.create();
         
-        car_.edgeEffectShader = &edgeEffectShader_;
-        car_.celShadingShader = &celShadingShader_;
-        car_.material = &material_;
-        
-        grassTexture_.load("../textures/grass.jpg");
-        grassTexture_.setWrap(GL_REPEAT);
-        grassTexture_.setFiltering(GL_LINEAR);
-        grassTexture_.enableMipmap();
-
-        streetTexture_.load("../textures/street.jpg");
-        streetTexture_.setWrap(GL_REPEAT);
-        streetTexture_.setFiltering(GL_LINEAR);
-        streetTexture_.enableMipmap();
-
-        streetcornerTexture_.load("../textures/streetcorner.jpg");
-        streetcornerTexture_.setWrap(GL_CLAMP_TO_EDGE);
-        streetcornerTexture_.setFiltering(GL_LINEAR);
-
-
-        carTexture_.load("../textures/car.png");
-        carTexture_.setWrap(GL_CLAMP_TO_EDGE);
-        carTexture_.setFiltering(GL_LINEAR);
-
-        carWindowTexture_.load("../textures/window.png");
-        carWindowTexture_.setWrap(GL_CLAMP_TO_EDGE);
-        carWindowTexture_.setFiltering(GL_NEAREST);
-
-        treeTexture_.load("../textures/pine.jpg");
-        treeTexture_.setWrap(GL_REPEAT);
-        treeTexture_.setFiltering(GL_NEAREST);
-
-        streetlightTexture_.load("../textures/streetlight.jpg");
-        streetlightTexture_.setWrap(GL_REPEAT);
-        streetlightTexture_.setFiltering(GL_LINEAR);
-
-	    streetTexture_.use();
-	    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_LOD_BIAS, -1.0f);
-	    
-        
-        const char* pathes[] = {
-            "../textures/skybox/Daylight Box_Right.bmp",
-            "../textures/skybox/Daylight Box_Left.bmp",
-            "../textures/skybox/Daylight Box_Top.bmp",
-            "../textures/skybox/Daylight Box_Bottom.bmp",
-            "../textures/skybox/Daylight Box_Front.bmp",
-            "../textures/skybox/Daylight Box_Back.bmp",
-        };
-        
-        const char* nightPathes[] = {
-            "../textures/skyboxNight/right.png",
-            "../textures/skyboxNight/left.png",
-            "../textures/skyboxNight/top.png",
-            "../textures/skyboxNight/bottom.png",
-            "../textures/skyboxNight/front.png",
-            "../textures/skyboxNight/back.png",
-        };
-        skyboxTexture_.load(pathes);
-        skyboxNightTexture_.load(nightPathes);
-
         
         initStaticModelMatrices();
+        initStaticInstances();
         
-        material_.allocate(&defaultMat, sizeof(Material));
+        material_.allocateRing(&defaultMat, sizeof(Material), MAX_MATERIAL_UPDATES_PER_FRAME);
         material_.setBindingIndex(0);
         
-        lightsData_.dirLight =
+        dirLight_ =
         {
             {0.2f, 0.2f, 0.2f, 0.0f},
             {1.0f, 1.0f, 1.0f, 0.0f},
@@ -396,34 +355,32 @@ struct App : public OpenGLApplication
             {0.5f, -1.0f, 0.5f, 0.0f}
         };
         
+        spotLights_.allocate(N_STREETLIGHTS + N_CAR_LIGHTS);
+        spotLights_.setBindingIndex(5);
+        BoundingSphere streetlightSpheres[N_STREETLIGHTS];
         for (unsigned int i = 0; i < N_STREETLIGHTS; i++)
-        {                
-            lightsData_.spotLights[i].position = glm::vec4(streetlightLightPositions[i], 0.0f);
-            lightsData_.spotLights[i].direction = glm::vec3(0, -1, 0);
-            lightsData_.spotLights[i].exponent = 6.0f;
-            lightsData_.spotLights[i].openingAngle = 60.f;        
+        {
+            SpotLight light = {};
+            light.position = glm::vec4(streetlightLightPositions[i], 0.0f);
+            light.direction = glm::vec3(0, -1, 0);
+            light.exponent = 6.0f;
+            light.openingAngle = 60.f;
+            light.shadowMapIndex = -1;
+            streetlightLights_[i] = spotLights_.addSpotLight(light);
+            streetlightSpheres[i] = {streetlightLightPositions[i], 0.0f};
         }
+        streetlightBvh_.build(streetlightSpheres, N_STREETLIGHTS);
         
-        lightsData_.spotLights[N_STREETLIGHTS].position = glm::vec4(-1.6, 0.64, -0.45, 0.0f);
-        lightsData_.spotLights[N_STREETLIGHTS].direction = glm::vec3(-10, -1, 0);
-        lightsData_.spotLights[N_STREETLIGHTS].exponent = 4.0f;
-        lightsData_.spotLights[N_STREETLIGHTS].openingAngle = 30.f;
-            
-        lightsData_.spotLights[N_STREETLIGHTS+1].position = glm::vec4(-1.6, 0.64, 0.45, 0.0f);
-        lightsData_.spotLights[N_STREETLIGHTS+1].direction = glm::vec3(-10, -1, 0);
-        lightsData_.spotLights[N_STREETLIGHTS+1].exponent = 4.0f;
-        lightsData_.spotLights[N_STREETLIGHTS+1].openingAngle = 30.f;
-            
-        lightsData_.spotLights[N_STREETLIGHTS+2].position = glm::vec4(1.6, 0.64, -0.45, 0.0f);
-        lightsData_.spotLights[N_STREETLIGHTS+2].direction = glm::vec3(10, -1, 0);
-        lightsData_.spotLights[N_STREETLIGHTS+2].exponent = 4.0f;
-        lightsData_.spotLights[N_STREETLIGHTS+2].openingAngle = 60.f;
-                   
-        lightsData_.spotLights[N_STREETLIGHTS+3].position = glm::vec4(1.6, 0.64, 0.45, 0.0f);
-        lightsData_.spotLights[N_STREETLIGHTS+3].direction = glm::vec3(10, -1, 0);
-        lightsData_.spotLights[N_STREETLIGHTS+3].exponent = 4.0f;
-        lightsData_.spotLights[N_STREETLIGHTS+3].openingAngle = 60.f;
-        
+        // Phares, puis feux de freinage. Seuls les phares ont une ombre, dans
+        // les tuiles 0 et 1 de l'atlas.
+        for (unsigned int i = 0; i < N_CAR_LIGHTS; i++)
+        {
+            SpotLight light = {};
+            light.exponent = 4.0f;
+            light.openingAngle = i < 2 ? 30.f : 60.f;
+            light.shadowMapIndex = i < 2 ? i : -1;
+            carLights_[i] = spotLights_.addSpotLight(light);
+        }
         
         toggleSun();
         toggleStreetlight();
@@ -431,12 +388,23 @@ struct App : public OpenGLApplication
         
         setLightingUniform();
         
-        lights_.allocate(&lightsData_, sizeof(lightsData_));
+        lights_.allocate(&dirLight_, sizeof(dirLight_));
         lights_.setBindingIndex(1);
+        lightClusters_.init(4);
+        shadowMaps_.init(2);
+        occlusionCuller_.init(6, 7);
+        shadowMaps_.setDirectionalLight(dirLight_);
         
-        CHECK_GL_ERROR;
+        assetLoader_.finish();
+
+        // Les grandes textures du sol sont téléversées par bandes pendant les premières trames.
+        streamMaterialTexture(LAYER_GRASS, "../textures/grass.jpg");
+        streamMaterialTexture(LAYER_STREET, "../textures/street.jpg");
 
-        loadModels();
+        initStaticBounds();
+        initOcclusionCulling();
+
+        CHECK_GL_ERROR;
 	}
 
 
@@ -448,19 +416,33 @@ struct App : public OpenGLApplication
         ImGui::Combo("Scene", &currentScene_, SCENE_NAMES, N_SCENE_NAMES);
         if (ImGui::Button("Reload Shaders"))
         {
-            particleComputeShader_.create();
-            particleDrawShader_.create(); 
-            edgeEffectShader_.create();
+            particles_.reloadShaders();
+            for (auto& shaders : particleDrawShaders_)
+                for (ParticleDrawShader* shader : shaders)
+                    shader->create();
+            softParticlePass_.reloadShaders();
+            outlinePass_.reloadShader();
+            transparencyPass_.reloadShader();
+            transparentCelShadingShader_.create();
             celShadingShader_.create();
+            instancedCelShadingShader_.create();
             skyShader_.create();
             grassShader_.create();
+            lightClusters_.reloadShader();
+            shadowMaps_.reloadShader();
+            occlusionCuller_.reloadShaders();
             
             setLightingUniform();
         }
         
         ImGui::End();
         
+        assetLoader_.update();
+        textureStreamer_.update();
+        
+        material_.beginFrame();
         sceneMain();
+        material_.endFrame();
 	}
 
 	void onClose() override
@@ -495,6 +477,13 @@ struct App : public OpenGLApplication
 		}
 	}
 
+	void onMouseButtonPress(const sf::Event::MouseButtonPressed& mouseBtn) override
+	{
+	    if (isMouseMotionEnabled_ || mouseBtn.button != sf::Mouse::Button::Left || ImGui::GetIO().WantCaptureMouse)
+	        return;
+	    pickStaticInstance(mouseBtn.position);
+	}
+
 	void onResize(const sf::Event::Resized& event) override
 	{	
 	}
@@ -561,13 +550,69 @@ struct App : public OpenGLApplication
         cameraPosition_ += positionOffset * glm::vec3(deltaTime_);
     }
     
-    void loadModels()
+    void loadTextures(AssetLoader& loader)
+    {
+        smokeTexture_.load("../textures/smoke.png", loader);
+        smokeTexture_.setWrap(GL_CLAMP_TO_EDGE);
+        smokeTexture_.setFiltering(GL_LINEAR);
+        smokeTexture_.enableMipmap();
+
+        // Un tableau par taille de couche; le mode de répétition et le biais de LOD
+        // de chaque texture sont dans son Material.
+        for (int i = 0; i < N_MATERIAL_TEXTURE_ARRAYS; i++)
+        {
+            const MaterialTextureArrayDesc& desc = MATERIAL_TEXTURE_ARRAYS[i];
+            materialTextures_[i].allocate(desc.size, desc.nLayers, desc.internalFormat);
+        }
+        loadMaterialTexture(LAYER_STREETCORNER, "../textures/streetcorner.jpg", loader);
+        loadMaterialTexture(LAYER_CAR, "../textures/car.png", loader);
+        loadMaterialTexture(LAYER_WINDOW, "../textures/window.png", loader);
+        loadMaterialTexture(LAYER_PINE, "../textures/pine.jpg", loader);
+        loadMaterialTexture(LAYER_STREETLIGHT, "../textures/streetlight.jpg", loader);
+
+        const char* nightPathes[] = {
+            "../textures/skyboxNight/right.png",
+            "../textures/skyboxNight/left.png",
+            "../textures/skyboxNight/top.png",
+            "../textures/skyboxNight/bottom.png",
+            "../textures/skyboxNight/front.png",
+            "../textures/skyboxNight/back.png",
+        };
+        skyboxNightTexture_.load(nightPathes, loader);
+    }
+
+    void loadMaterialTexture(GLint texture, const char* path, AssetLoader& loader)
+    {
+        materialTextures_[getMaterialTextureArray(texture)].loadLayer(getMaterialTextureLayer(texture), path, loader);
+    }
+
+    void streamMaterialTexture(GLint texture, const char* path)
+    {
+        materialTextures_[getMaterialTextureArray(texture)].loadLayer(getMaterialTextureLayer(texture), path,
+                                                                      assetLoader_, textureStreamer_);
+    }
+
+    void loadDaySkybox()
+    {
+        const char* pathes[] = {
+            "../textures/skybox/Daylight Box_Right.bmp",
+            "../textures/skybox/Daylight Box_Left.bmp",
+            "../textures/skybox/Daylight Box_Top.bmp",
+            "../textures/skybox/Daylight Box_Bottom.bmp",
+            "../textures/skybox/Daylight Box_Front.bmp",
+            "../textures/skybox/Daylight Box_Back.bmp",
+        };
+        skyboxTexture_.load(pathes, assetLoader_, textureStreamer_);
+        isDaySkyboxLoaded_ = true;
+    }
+
+    void loadModels(AssetLoader& loader)
     {
-        car_.loadModels();
-        tree_.load("../models/pine.ply");
-        streetlight_.load("../models/streetlight.ply");
-        streetlightLight_.load("../models/streetlight_light.ply");
-        skybox_.load("../models/skybox.ply");
+        car_.loadModels(loader);
+        tree_.load("../models/pine.ply", loader);
+        streetlight_.load("../models/streetlight.ply", loader);
+        streetlightLight_.load("../models/streetlight_light.ply", loader);
+        skybox_.load("../models/skybox.ply", loader);
         grass_.load(ground, sizeof(ground), planeElements, sizeof(planeElements));
         street_.load(street, sizeof(street), planeElements, sizeof(planeElements));
         streetcorner_.load(streetcorner, sizeof(streetcorner), planeElements, sizeof(planeElements));
@@ -596,106 +641,207 @@ struct App : public OpenGLApplication
                 streetlightIndex++;
             }
         }
-    }
-    
-    void drawStreetlights(const glm::mat4& projView, const glm::mat4& view, bool forOutline = false)
-    {
-        if (!forOutline) {
-            celShadingShader_.use();
-        }
-
-        for (unsigned int i = 0; i < N_STREETLIGHTS; i++) {
-            const glm::mat4& model = streetlightModelMatrices_[i];
-            glm::mat4 mvp = projView * model;
-
-            if (forOutline) {
-                glUniformMatrix4fv(edgeEffectShader_.mvpULoc, 1, GL_FALSE, glm::value_ptr(mvp));
-                streetlight_.draw();
-                streetlightLight_.draw();
-            } else {
-                if (!isDay_)
-                    setMaterial(streetlightLightMat);
-                else
-                    setMaterial(streetlightMat);
-                celShadingShader_.setMatrices(mvp, view, model);
-                streetlightLight_.draw();
-            
-                setMaterial(streetlightMat);
-                streetlightTexture_.use();
-                celShadingShader_.setMatrices(mvp, view, model);
-                streetlight_.draw();
-            }
-        }
-    }
-    
-    void drawTree(const glm::mat4& projView, const glm::mat4& view, bool forOutline = false)
-    {
-        glDisable(GL_CULL_FACE);
-
-        glm::mat4 treeModel =  glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.1f, 1.0f));
-        treeModel = glm::scale(treeModel, glm::vec3(15.0f, 15.0f, 15.0f));
-        glm::mat4 treeMVP = projView * treeModel;
-
-        if (forOutline)
-            glUniformMatrix4fv(edgeEffectShader_.mvpULoc, 1, GL_FALSE, glm::value_ptr(treeMVP));
-        else
-            celShadingShader_.setMatrices(treeMVP, view, treeModel);
-
-        tree_.draw();
-        glEnable(GL_CULL_FACE);
-    }
-    
-    void drawGround(const glm::mat4& projView, const glm::mat4& view)
-    {
-        setMaterial(grassMat);
-
-        glm::mat4 grassModel = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.1f, 0.0f));
-        grassModel = glm::scale(grassModel, glm::vec3(50.0f, 1.0f, 50.0f));
 
-        glm::mat4 grassMVP = projView * grassModel;
-        celShadingShader_.setMatrices(grassMVP, view, grassModel);
-        grassTexture_.use();
-        grass_.draw();
+        groundModelMatrice_ = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.1f, 0.0f));
+        grassBladesModelMatrice_ = groundModelMatrice_;
+        groundModelMatrice_ = glm::scale(groundModelMatrice_, glm::vec3(50.0f, 1.0f, 50.0f));
 
+        // Les segments de route d'abord, puis les coins: deux plages d'instances.
         const float ROAD_OFFSET = 20.0f;
         const float ROAD_SPACING = 5.0f;
-        const int N_ROAD_SEGMENT = 7;
 
-        setMaterial(streetMat);
-        streetTexture_.use();
         for (int side = 0; side < 4; ++side) {
             float angle = glm::radians(90.0f * side);
 
-            for (int i = 0; i < N_ROAD_SEGMENT; ++i) {
-                float segmentPos = (i - (N_ROAD_SEGMENT / 2)) * ROAD_SPACING;
-
-                streetTexture_.use();
+            for (int i = 0; i < N_ROAD_SEGMENTS; ++i) {
+                float segmentPos = (i - (N_ROAD_SEGMENTS / 2)) * ROAD_SPACING;
 
                 glm::mat4 roadModel = glm::mat4(1.0f);
                 roadModel = glm::rotate(roadModel, angle, glm::vec3(0.0f, 1.0f, 0.0f));
                 roadModel = glm::translate(roadModel ,glm::vec3(segmentPos, 0.0f, ROAD_OFFSET));
                 roadModel = glm::scale(roadModel, glm::vec3(5.0f, 1.0f, 5.0f));
-
-                glm::mat4 roadMVP = projView * roadModel;
-                celShadingShader_.setMatrices(roadMVP, view, roadModel);
-                
-                street_.draw();
+                streetPatchesModelMatrices_[side * N_ROAD_SEGMENTS + i] = roadModel;
             }
-        }
-
-        streetcornerTexture_.use();
-        for (int side = 0; side < 4; ++side) {
-            float angle = glm::radians(90.0f * side);
 
             glm::mat4 cornerModel = glm::mat4(1.0f);
             cornerModel = glm::rotate(cornerModel, angle, glm::vec3(0.0f, 1.0f, 0.0f));
             cornerModel = glm::translate(cornerModel, glm::vec3(ROAD_OFFSET, 0.0f, ROAD_OFFSET));
             cornerModel = glm::scale(cornerModel, glm::vec3(5.0f, 1.0f, 5.0f));
+            streetPatchesModelMatrices_[N_ROAD_PATCHES + side] = cornerModel;
+        }
+
+        treeModelMatrices_[0] = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.1f, 1.0f));
+        treeModelMatrices_[0] = glm::scale(treeModelMatrices_[0], glm::vec3(15.0f, 15.0f, 15.0f));
+    }
+    
+    // Les objets statiques ne changent jamais de matrice: leurs instances sont
+    // écrites une seule fois et chaque type est dessiné en un seul appel. Le
+    // produit par projView se fait dans le nuanceur de sommets.
+    void initStaticInstances()
+    {
+        glm::mat4 identity = glm::mat4(1.0f);
+
+        groundInstances_ = transforms_.addStatic(&groundModelMatrice_, 1, MATERIAL_GRASS);
+        streetInstances_ = transforms_.addStatic(streetPatchesModelMatrices_, N_ROAD_PATCHES, MATERIAL_STREET);
+        streetcornerInstances_ = transforms_.addStatic(streetPatchesModelMatrices_ + N_ROAD_PATCHES,
+                                                       N_STREET_PATCHES - N_ROAD_PATCHES, MATERIAL_STREETCORNER);
+        treeInstances_ = transforms_.addStatic(treeModelMatrices_, N_TREES, MATERIAL_TREE);
+        streetlightInstances_ = transforms_.addStatic(streetlightModelMatrices_, N_STREETLIGHTS, MATERIAL_STREETLIGHT);
+        streetlightLightInstances_ = transforms_.addStatic(streetlightModelMatrices_, N_STREETLIGHTS, MATERIAL_STREETLIGHT_LIGHT);
+        identityInstance_ = transforms_.addStatic(&identity, 1, 0);
+
+        transforms_.allocate(MAX_DYNAMIC_TRANSFORMS);
+        transforms_.setBindingIndex(2);
+
+        Material materials[N_MATERIALS];
+        materials[MATERIAL_GRASS] = grassMat;
+        materials[MATERIAL_STREET] = streetMat;
+        materials[MATERIAL_STREETCORNER] = streetcornerMat;
+        materials[MATERIAL_TREE] = treeMat;
+        materials[MATERIAL_STREETLIGHT] = streetlightMat;
+        materials[MATERIAL_STREETLIGHT_LIGHT] = isDay_ ? streetlightMat : streetlightLightMat;
+        car_.initMaterials(defaultMat, MATERIAL_CAR, &materials[MATERIAL_CAR]);
+        materialTable_.allocate(materials, sizeof(materials), GL_DYNAMIC_DRAW);
+        materialTable_.setBindingIndex(3);
+    }
+
+    // Les volumes des modèles ne sont connus qu'une fois ceux-ci chargés.
+    void initStaticBounds()
+    {
+        // Toutes les instances statiques précèdent l'instance identité de la courbe, jamais testée.
+        staticInstanceSpheres_.resize(identityInstance_.first);
+        staticInstanceVisibility_.resize(identityInstance_.first, 1);
+        addStaticBounds(grass_, groundInstances_);
+        addStaticBounds(street_, streetInstances_);
+        addStaticBounds(streetcorner_, streetcornerInstances_);
+        addStaticBounds(tree_, treeInstances_);
+        addStaticBounds(streetlight_, streetlightInstances_);
+        addStaticBounds(streetlightLight_, streetlightLightInstances_);
+        staticBvh_.build(staticInstanceSpheres_.data(), staticInstanceSpheres_.size());
+
+        // Le sol et la route reçoivent les ombres sans en projeter.
+        shadowMaps_.addStaticCaster(tree_, treeInstances_,
+                                    enclosingSphere(&staticInstanceSpheres_[treeInstances_.first], treeInstances_.count));
+        for (unsigned int i = 0; i < N_STREETLIGHTS; i++)
+        {
+            GLuint instance = streetlightInstances_.first + i;
+            shadowMaps_.addStaticCaster(streetlight_, {instance, 1}, staticInstanceSpheres_[instance]);
+        }
+    }
+
+    // Mêmes groupes que cullStaticInstances, testés sur le GPU.
+    void initOcclusionCulling()
+    {
+        const BoundingSphere* spheres = staticInstanceSpheres_.data();
+        occlusionCuller_.add(grass_, groundInstances_, spheres);
+        occlusionCuller_.add(street_, streetInstances_, spheres);
+        occlusionCuller_.add(streetcorner_, streetcornerInstances_, spheres);
+        occludedGroundDraws_ = occlusionCuller_.endGroup();
+
+        occlusionCuller_.add(tree_, treeInstances_, spheres);
+        occludedTreeDraws_ = occlusionCuller_.endGroup();
+
+        occlusionCuller_.add(streetlightLight_, streetlightLightInstances_, spheres);
+        occlusionCuller_.add(streetlight_, streetlightInstances_, spheres);
+        occludedStreetlightDraws_ = occlusionCuller_.endGroup();
+
+        occlusionCuller_.upload();
+    }
+
+    void addStaticBounds(const Model& model, const InstanceRange& instances)
+    {
+        for (GLuint i = instances.first; i < instances.first + instances.count; i++)
+            staticInstanceSpheres_[i] = transformSphere(model.bounds().sphere, transforms_.getModel(i));
+    }
+
+    // Reconstruit les commandes des objets statiques avec les seules instances
+    // visibles; la passe principale et celle des contours partagent le résultat.
+    void cullStaticInstances(const Frustum& frustum)
+    {
+        staticBvh_.cull(frustum, staticInstanceVisibility_.data());
+        const uint8_t* isVisible = staticInstanceVisibility_.data();
+
+        drawCommands_.clear();
+        drawCommands_.addVisible(grass_, groundInstances_, isVisible);
+        drawCommands_.addVisible(street_, streetInstances_, isVisible);
+        drawCommands_.addVisible(streetcorner_, streetcornerInstances_, isVisible);
+        groundDraws_ = drawCommands_.endGroup();
 
-            glm::mat4 cornerMVP = projView * cornerModel;
-            celShadingShader_.setMatrices(cornerMVP, view, cornerModel);
-            streetcorner_.draw();
+        drawCommands_.addVisible(tree_, treeInstances_, isVisible);
+        treeDraws_ = drawCommands_.endGroup();
+
+        drawCommands_.addVisible(streetlightLight_, streetlightLightInstances_, isVisible);
+        drawCommands_.addVisible(streetlight_, streetlightInstances_, isVisible);
+        streetlightDraws_ = drawCommands_.endGroup();
+
+        drawCommands_.upload();
+    }
+
+    void updateStreetlightMaterial()
+    {
+        Material& mat = isDay_ ? streetlightMat : streetlightLightMat;
+        materialTable_.updateData(&mat, MATERIAL_STREETLIGHT_LIGHT * sizeof(Material), sizeof(Material));
+    }
+    
+    // Utilise le nuanceur instancié déjà lié. Sans
+    // élimination des objets cachés, tout est dessiné à la phase précoce.
+    void drawStreetlights(OcclusionCuller::Pass pass)
+    {
+        if (isOcclusionCullingEnabled_)
+            occlusionCuller_.draw(occludedStreetlightDraws_, pass);
+        else if (pass != OcclusionCuller::LATE_PASS)
+            drawCommands_.draw(streetlightDraws_);
+    }
+    
+    void drawTree(OcclusionCuller::Pass pass)
+    {
+        glDisable(GL_CULL_FACE);
+        if (isOcclusionCullingEnabled_)
+            occlusionCuller_.draw(occludedTreeDraws_, pass);
+        else if (pass != OcclusionCuller::LATE_PASS)
+            drawCommands_.draw(treeDraws_);
+        glEnable(GL_CULL_FACE);
+    }
+    
+    void drawGround(OcclusionCuller::Pass pass)
+    {
+        if (isOcclusionCullingEnabled_)
+            occlusionCuller_.draw(occludedGroundDraws_, pass);
+        else if (pass != OcclusionCuller::LATE_PASS)
+            drawCommands_.draw(groundDraws_);
+    }
+    
+    // Façons de composer les particules, chacune avec un nuanceur par
+    // ParticleSystem::DrawMode.
+    enum ParticleShading
+    {
+        OIT_PARTICLE_SHADING,
+        SORTED_PARTICLE_SHADING,
+        SOFT_PARTICLE_SHADING,
+        N_PARTICLE_SHADINGS
+    };
+    
+    // En mode comparaison, les deux méthodes alternent d'une image à l'autre.
+    void drawParticles(ParticleShading shading, const glm::mat4& proj, const glm::mat4& view)
+    {
+        ParticleSystem::DrawMode mode = (ParticleSystem::DrawMode)particleDrawMode_;
+        if (isParticleDrawBenchmarkEnabled_)
+        {
+            particleBenchmarkFrame_ = 1 - particleBenchmarkFrame_;
+            mode = (ParticleSystem::DrawMode)particleBenchmarkFrame_;
         }
+
+        ParticleDrawShader& shader = *particleDrawShaders_[shading][mode];
+        shader.use();
+        glUniformMatrix4fv(shader.projectionULoc, 1, GL_FALSE, glm::value_ptr(proj));
+        glUniformMatrix4fv(shader.modelViewULoc, 1, GL_FALSE, glm::value_ptr(view));
+        glUniform1i(shader.textureSamplerULoc, 0);
+        glm::vec2 depthParams = getDepthParams(proj);
+        glUniform2f(shader.depthParamsULoc, depthParams.x, depthParams.y);
+        glUniform1f(shader.softnessULoc, PARTICLE_SOFTNESS);
+
+        smokeTexture_.use();
+        particles_.draw(mode);
     }
     
     glm::mat4 getViewMatrix()
@@ -711,107 +857,148 @@ struct App : public OpenGLApplication
 
     void setLightingUniform()
     {
-        celShadingShader_.use();
-        glUniform1i(celShadingShader_.nSpotLightsULoc, N_STREETLIGHTS+4);
-        
         float ambientIntensity = 0.05;
-        glUniform3f(celShadingShader_.globalAmbientULoc, ambientIntensity, ambientIntensity, ambientIntensity);
+        CelShading* shaders[] = {&celShadingShader_, &instancedCelShadingShader_, &transparentCelShadingShader_};
+        for (CelShading* shader : shaders)
+        {
+            shader->use();
+            glUniform3f(shader->globalAmbientULoc, ambientIntensity, ambientIntensity, ambientIntensity);
+        }
     }
 
     void toggleSun()
     {
         if (isDay_)
         {
-            lightsData_.dirLight.ambient = glm::vec4(0.2f, 0.2f, 0.2f, 0.0f); 
-            lightsData_.dirLight.diffuse = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
-            lightsData_.dirLight.specular = glm::vec4(0.5f, 0.5f, 0.5f, 0.0f);
+            dirLight_.ambient = glm::vec4(0.2f, 0.2f, 0.2f, 0.0f); 
+            dirLight_.diffuse = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+            dirLight_.specular = glm::vec4(0.5f, 0.5f, 0.5f, 0.0f);
         }
         else
         {
-            lightsData_.dirLight.ambient = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f); 
-            lightsData_.dirLight.diffuse = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
-            lightsData_.dirLight.specular = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
+            dirLight_.ambient = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f); 
+            dirLight_.diffuse = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
+            dirLight_.specular = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
         }
     }
     
     void toggleStreetlight()
     {
-        if (isDay_)
+        glm::vec3 intensity = isDay_ ? glm::vec3(0.0f) : glm::vec3(1.0f);
+        for (unsigned int i = 0; i < N_STREETLIGHTS; i++)
         {
-            for (unsigned int i = 0; i < N_STREETLIGHTS; i++)
-            {
-                lightsData_.spotLights[i].ambient = glm::vec4(glm::vec3(0.0f), 0.0f);
-                lightsData_.spotLights[i].diffuse = glm::vec4(glm::vec3(0.0f), 0.0f);
-                lightsData_.spotLights[i].specular = glm::vec4(glm::vec3(0.0f), 0.0f);
-            }
+            SpotLight light = spotLights_.getSpotLight(streetlightLights_[i]);
+            light.ambient = glm::vec4(0.02f * intensity, 0.0f);
+            light.diffuse = glm::vec4(0.8f * intensity, 0.0f);
+            light.specular = glm::vec4(0.4f * intensity, 0.0f);
+            spotLights_.updateSpotLight(streetlightLights_[i], light);
         }
-        else
+    }
+
+    void updateCarLight()
+    {
+        static const glm::vec3 CAR_LIGHT_POSITIONS[N_CAR_LIGHTS] =
         {
-            for (unsigned int i = 0; i < N_STREETLIGHTS; i++)
+            {-1.6f, 0.64f, -0.45f},
+            {-1.6f, 0.64f, 0.45f},
+            {1.6f, 0.64f, -0.45f},
+            {1.6f, 0.64f, 0.45f}
+        };
+        
+        for (unsigned int i = 0; i < N_CAR_LIGHTS; i++)
+        {
+            bool isHeadlight = i < 2;
+            bool isOn = isHeadlight ? car_.isHeadlightOn : car_.isBraking;
+            
+            SpotLight light = spotLights_.getSpotLight(carLights_[i]);
+            if (isOn)
             {
-                lightsData_.spotLights[i].ambient = glm::vec4(glm::vec3(0.02f), 0.0f);
-                lightsData_.spotLights[i].diffuse = glm::vec4(glm::vec3(0.8f), 0.0f);
-                lightsData_.spotLights[i].specular = glm::vec4(glm::vec3(0.4f), 0.0f);
+                if (isHeadlight)
+                {
+                    light.ambient = glm::vec4(glm::vec3(0.01), 0.0f);
+                    light.diffuse = glm::vec4(glm::vec3(1.0), 0.0f);
+                    light.specular = glm::vec4(glm::vec3(0.4), 0.0f);
+                }
+                else
+                {
+                    light.ambient = glm::vec4(0.01, 0.0, 0.0, 0.0f);
+                    light.diffuse = glm::vec4(0.9, 0.1, 0.1, 0.0f);
+                    light.specular = glm::vec4(0.35, 0.05, 0.05, 0.0f);
+                }
+                light.position = car_.carModel * glm::vec4(CAR_LIGHT_POSITIONS[i], 1.0f);
+                light.direction = glm::mat3(car_.carModel) * glm::vec3(isHeadlight ? -10.0f : 10.0f, -1.0f, 0.0f);
+            }
+            else
+            {
+                light.ambient = glm::vec4(0.0f);
+                light.diffuse = glm::vec4(0.0f);
+                light.specular = glm::vec4(0.0f);
             }
+            spotLights_.updateSpotLight(carLights_[i], light);
+            if (light.shadowMapIndex >= 0)
+                shadowMaps_.setSpotLight(light.shadowMapIndex, isOn ? &light : nullptr);
         }
     }
 
-    void updateCarLight()
-{
-    if (car_.isHeadlightOn)
+    // Le lampadaire le plus proche de la voiture prend la tuile libre de
+    // l'atlas: c'est sous lui que l'ombre de la voiture se voit.
+    void updateStreetlightShadow()
     {
-        lightsData_.spotLights[N_STREETLIGHTS].ambient = glm::vec4(glm::vec3(0.01), 0.0f);
-        lightsData_.spotLights[N_STREETLIGHTS].diffuse = glm::vec4(glm::vec3(1.0), 0.0f);
-        lightsData_.spotLights[N_STREETLIGHTS].specular = glm::vec4(glm::vec3(0.4), 0.0f);
-        
-        lightsData_.spotLights[N_STREETLIGHTS+1].ambient = glm::vec4(glm::vec3(0.01), 0.0f);
-        lightsData_.spotLights[N_STREETLIGHTS+1].diffuse = glm::vec4(glm::vec3(1.0), 0.0f);
-        lightsData_.spotLights[N_STREETLIGHTS+1].specular = glm::vec4(glm::vec3(0.4), 0.0f);
-        
-        lightsData_.spotLights[N_STREETLIGHTS].position = car_.carModel * glm::vec4(-1.6f, 0.64f, -0.45f, 1.0f);
-        lightsData_.spotLights[N_STREETLIGHTS].direction = glm::mat3(car_.carModel) * glm::vec3(-10.0f, -1.0f, 0.0f);
-        
-        lightsData_.spotLights[N_STREETLIGHTS+1].position = car_.carModel * glm::vec4(-1.6f, 0.64f, 0.45f, 1.0f);
-        lightsData_.spotLights[N_STREETLIGHTS+1].direction = glm::mat3(car_.carModel) * glm::vec3(-10.0f, -1.0f, 0.0f);
+        uint32_t nearest = streetlightBvh_.findNearest(car_.position, LightClusters::LIGHT_RADIUS);
+        GLint shadowed = nearest == StaticBvh::INVALID_ITEM ? -1 : (GLint)nearest;
+        if (shadowed != shadowedStreetlight_)
+        {
+            if (shadowedStreetlight_ >= 0)
+            {
+                SpotLight light = spotLights_.getSpotLight(streetlightLights_[shadowedStreetlight_]);
+                light.shadowMapIndex = -1;
+                spotLights_.updateSpotLight(streetlightLights_[shadowedStreetlight_], light);
+            }
+            if (shadowed >= 0)
+            {
+                SpotLight light = spotLights_.getSpotLight(streetlightLights_[shadowed]);
+                light.shadowMapIndex = STREETLIGHT_SHADOW_TILE;
+                spotLights_.updateSpotLight(streetlightLights_[shadowed], light);
+            }
+            shadowedStreetlight_ = shadowed;
+        }
+
+        // Les lampadaires sont éteints le jour.
+        bool isShadowed = shadowed >= 0 && !isDay_;
+        shadowMaps_.setSpotLight(STREETLIGHT_SHADOW_TILE,
+                                 isShadowed ? &spotLights_.getSpotLight(streetlightLights_[shadowed]) : nullptr);
     }
-    else
+
+    static bool isInRange(const InstanceRange& range, GLuint instance)
     {
-        lightsData_.spotLights[N_STREETLIGHTS].ambient = glm::vec4(0.0f);
-        lightsData_.spotLights[N_STREETLIGHTS].diffuse = glm::vec4(0.0f);
-        lightsData_.spotLights[N_STREETLIGHTS].specular = glm::vec4(0.0f);
-        
-        lightsData_.spotLights[N_STREETLIGHTS+1].ambient = glm::vec4(0.0f);
-        lightsData_.spotLights[N_STREETLIGHTS+1].diffuse = glm::vec4(0.0f);
-        lightsData_.spotLights[N_STREETLIGHTS+1].specular = glm::vec4(0.0f);
+        return instance >= range.first && instance < range.first + (GLuint)range.count;
     }
-    
-    if (car_.isBraking)
+
+    const char* getStaticInstanceName(GLuint instance) const
     {
-        lightsData_.spotLights[N_STREETLIGHTS+2].ambient = glm::vec4(0.01, 0.0, 0.0, 0.0f);
-        lightsData_.spotLights[N_STREETLIGHTS+2].diffuse = glm::vec4(0.9, 0.1, 0.1, 0.0f);
-        lightsData_.spotLights[N_STREETLIGHTS+2].specular = glm::vec4(0.35, 0.05, 0.05, 0.0f);
-        
-        lightsData_.spotLights[N_STREETLIGHTS+3].ambient = glm::vec4(0.01, 0.0, 0.0, 0.0f);
-        lightsData_.spotLights[N_STREETLIGHTS+3].diffuse = glm::vec4(0.9, 0.1, 0.1, 0.0f);
-        lightsData_.spotLights[N_STREETLIGHTS+3].specular = glm::vec4(0.35, 0.05, 0.05, 0.0f);
-        
-        lightsData_.spotLights[N_STREETLIGHTS+2].position = car_.carModel * glm::vec4(1.6f, 0.64f, -0.45f, 1.0f);        
-        lightsData_.spotLights[N_STREETLIGHTS+2].direction = glm::mat3(car_.carModel) * glm::vec3(10.0f, -1.0f, 0.0f);
-        
-        lightsData_.spotLights[N_STREETLIGHTS+3].position = car_.carModel * glm::vec4(1.6f, 0.64f, 0.45f, 1.0f);
-        lightsData_.spotLights[N_STREETLIGHTS+3].direction = glm::mat3(car_.carModel) * glm::vec3(10.0f, -1.0f, 0.0f);
+        if (isInRange(groundInstances_, instance))
+            return "Ground";
+        if (isInRange(streetInstances_, instance) || isInRange(streetcornerInstances_, instance))
+            return "Street";
+        if (isInRange(treeInstances_, instance))
+            return "Tree";
+        if (isInRange(streetlightInstances_, instance) || isInRange(streetlightLightInstances_, instance))
+            return "Streetlight";
+        return "Object";
     }
-    else
+
+    // Premier objet statique sous le curseur, d'après leurs sphères englobantes.
+    void pickStaticInstance(const sf::Vector2i& position)
     {
-        lightsData_.spotLights[N_STREETLIGHTS+2].ambient = glm::vec4(0.0f);
-        lightsData_.spotLights[N_STREETLIGHTS+2].diffuse = glm::vec4(0.0f);
-        lightsData_.spotLights[N_STREETLIGHTS+2].specular = glm::vec4(0.0f);
-        
-        lightsData_.spotLights[N_STREETLIGHTS+3].ambient = glm::vec4(0.0f);
-        lightsData_.spotLights[N_STREETLIGHTS+3].diffuse = glm::vec4(0.0f);
-        lightsData_.spotLights[N_STREETLIGHTS+3].specular = glm::vec4(0.0f);
+        sf::Vector2u windowSize = window_.getSize();
+        glm::vec2 ndc(2.0f * position.x / windowSize.x - 1.0f, 1.0f - 2.0f * position.y / windowSize.y);
+        glm::mat4 invProjView = glm::inverse(getPerspectiveProjectionMatrix() * getViewMatrix());
+        glm::vec4 nearPoint = invProjView * glm::vec4(ndc, -1.0f, 1.0f);
+        glm::vec4 farPoint = invProjView * glm::vec4(ndc, 1.0f, 1.0f);
+        glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+        glm::vec3 direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
+        pickedInstance_ = staticBvh_.raycast(origin, direction, pickedDistance_, CAMERA_FAR);
     }
-}
 
     void setMaterial(Material& mat)
     {
@@ -820,12 +1007,10 @@ struct App : public OpenGLApplication
     
     glm::mat4 getPerspectiveProjectionMatrix()
     {
-        float fov = glm::radians(70.0f);
+        float fov = glm::radians(CAMERA_FOV);
         float aspect = getWindowAspect();
-        float near = 0.1f;
-        float far = 300.0f;
         
-        return glm::perspective(fov, aspect, near, far);
+        return glm::perspective(fov, aspect, CAMERA_NEAR, CAMERA_FAR);
     }
 
     glm::vec3 calculateBezier(BezierCurve& curve, float t) {
@@ -853,9 +1038,13 @@ struct App : public OpenGLApplication
         if (ImGui::Button("Toggle Day/Night"))
         {
             isDay_ = !isDay_;
+            if (isDay_ && !isDaySkyboxLoaded_)
+                loadDaySkybox();
             toggleSun();
             toggleStreetlight();
-            lights_.updateData(&lightsData_, 0, sizeof(DirectionalLight) + N_STREETLIGHTS * sizeof(SpotLight));
+            updateStreetlightMaterial();
+            lights_.updateData(&dirLight_, 0, sizeof(DirectionalLight));
+            shadowMaps_.setDirectionalLight(dirLight_);
         }
         ImGui::SliderFloat("Car Speed", &car_.speed, -10.0f, 10.0f, "%.2f m/s");
         ImGui::SliderFloat("Steering Angle", &car_.steeringAngle, -30.0f, 30.0f, "%.2f°");
@@ -865,17 +1054,81 @@ struct App : public OpenGLApplication
         ImGui::Checkbox("Left Blinker", &car_.isLeftBlinkerActivated);
         ImGui::Checkbox("Right Blinker", &car_.isRightBlinkerActivated);
         ImGui::Checkbox("Brake", &car_.isBraking);
+        // Environ 570k particules/s gardent 1M particules vivantes.
+        ImGui::SliderFloat("Exhaust Rate", &exhaustRate_, 0.0f, 1000000.0f, "%.0f particles/s", ImGuiSliderFlags_Logarithmic);
+        if (ImGui::Combo("Particle Count", &particleCountIndex_, PARTICLE_COUNT_NAMES, N_PARTICLE_COUNTS))
+            particles_.setFixedCount(PARTICLE_COUNTS[particleCountIndex_]);
+        // Les particules douces n'utilisent pas l'ordre trié.
+        if (!isSoftParticlesEnabled_)
+        {
+            ImGui::Checkbox("Sort Particles", &isParticleSortingEnabled_);
+            if (isParticleSortingEnabled_)
+                ImGui::Text("Particle sort: %.3f ms", particles_.getLastSortTime());
+        }
+        ImGui::Combo("Particle Draw", &particleDrawMode_, PARTICLE_DRAW_MODE_NAMES, ParticleSystem::N_DRAW_MODES);
+        ImGui::Checkbox("Compare Particle Draws", &isParticleDrawBenchmarkEnabled_);
+        ImGui::Checkbox("Soft Particles", &isSoftParticlesEnabled_);
+        if (isSoftParticlesEnabled_)
+        {
+            // Réductions 1, 2, 4
+            int particleResolutionIndex = softParticlePass_.getDownscale() / 2;
+            if (ImGui::Combo("Particle Resolution", &particleResolutionIndex, PARTICLE_RESOLUTION_NAMES, N_PARTICLE_RESOLUTIONS))
+                softParticlePass_.setDownscale(1 << particleResolutionIndex);
+        }
+        for (int i = 0; i < ParticleSystem::N_DRAW_MODES; i++)
+            ImGui::Text("%s: %.3f ms", PARTICLE_DRAW_MODE_NAMES[i], particles_.getLastDrawTime((ParticleSystem::DrawMode)i));
+        ImGui::Text("Spotlight uploads: %u", spotLights_.getLastUploadCount());
+        if (pickedInstance_ != StaticBvh::INVALID_ITEM)
+            ImGui::Text("Picked: %s %u, %.1f m", getStaticInstanceName(pickedInstance_), pickedInstance_, pickedDistance_);
+        ImGui::Checkbox("Occlusion Culling", &isOcclusionCullingEnabled_);
+        int outlineThickness = outlinePass_.getThickness();
+        if (ImGui::SliderInt("Outline Thickness", &outlineThickness, 0, 8))
+            outlinePass_.setThickness(outlineThickness);
+        
+        int nShadowCascades = shadowMaps_.getCascadeCount();
+        if (ImGui::SliderInt("Shadow Cascades", &nShadowCascades, 1, ShadowMaps::MAX_CASCADES))
+            shadowMaps_.setCascadeCount(nShadowCascades);
+        int shadowResolutionIndex = 0;
+        while (SHADOW_RESOLUTIONS[shadowResolutionIndex] != shadowMaps_.getResolution() && shadowResolutionIndex < N_SHADOW_RESOLUTIONS - 1)
+            shadowResolutionIndex++;
+        if (ImGui::Combo("Shadow Resolution", &shadowResolutionIndex, SHADOW_RESOLUTION_NAMES, N_SHADOW_RESOLUTIONS))
+            shadowMaps_.setResolution(SHADOW_RESOLUTIONS[shadowResolutionIndex]);
         ImGui::End();
     
         updateCameraInput();
         car_.update(deltaTime_);
         
+        transforms_.beginFrame();
+        car_.updateTransforms(transforms_);
+        transforms_.upload(geometryPool_);
+        
+        shadowMaps_.beginFrame();
+        car_.addShadowCasters(shadowMaps_);
+        
         updateCarLight();
-        lights_.updateData(&lightsData_.spotLights[N_STREETLIGHTS], sizeof(DirectionalLight) + N_STREETLIGHTS * sizeof(SpotLight), 4 * sizeof(SpotLight));
+        updateStreetlightShadow();
+        spotLights_.upload();
                 
         glm::mat4 view = getViewMatrix();
         glm::mat4 proj = getPerspectiveProjectionMatrix();
         glm::mat4 projView = proj * view;
+        
+        sf::Vector2u windowSize = window_.getSize();
+        glm::vec2 viewportSize(windowSize.x, windowSize.y);
+        lightClusters_.update(view, proj, CAMERA_NEAR, CAMERA_FAR, spotLights_.getSpotLightCount());
+        
+        Frustum frustum(projView);
+        if (isOcclusionCullingEnabled_)
+            occlusionCuller_.cullEarly(frustum);
+        else
+            cullStaticInstances(frustum);
+        car_.cull(frustum);
+        
+        shadowMaps_.render(geometryPool_, view, glm::radians(CAMERA_FOV), getWindowAspect(), CAMERA_NEAR);
+        shadowMaps_.bindTextures();
+
+        // Toute la scène opaque va dans le tampon hors écran des contours.
+        outlinePass_.begin(windowSize.x, windowSize.y);
 
         if (isAnimatingCamera)
         {
@@ -926,24 +1179,31 @@ struct App : public OpenGLApplication
             glBindBuffer(GL_ARRAY_BUFFER, 0);
         }
 
+        // Les tableaux restent liés pour toutes les passes qui utilisent les matériaux.
+        for (int i = 0; i < N_MATERIAL_TEXTURE_ARRAYS; i++)
+        {
+            glActiveTexture(GL_TEXTURE0 + MATERIAL_TEXTURE_UNIT + i);
+            materialTextures_[i].use();
+        }
+        glActiveTexture(GL_TEXTURE0);
+
         // Dessin bezier
         celShadingShader_.use();
+        celShadingShader_.setViewMatrices(projView, view);
+        lightClusters_.setShaderUniforms(celShadingShader_, viewportSize);
         setMaterial(bezierMat);
         
-        glm::mat4 bezierModel = glm::mat4(1.0f);
-        glm::mat4 bezierMVP = projView * bezierModel;
-        celShadingShader_.setMatrices(bezierMVP, view, bezierModel);
+        // Le VAO de la courbe n'a pas d'attribut d'instance: sa valeur courante est utilisée.
+        glVertexAttribI4ui(GeometryPool::INSTANCE_INDEX_ATTRIBUTE, identityInstance_.first, 0, 0, 0);
 
         glBindVertexArray(vaoBezier_);
         glDrawArrays(GL_LINE_STRIP, 0, numBezierVerts_);
         glBindVertexArray(0);
         
         // Dessin grass
-        glm::mat4 groundModel = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.1f, 0.0f));
-
         grassShader_.use();
-        glUniformMatrix4fv(grassShader_.modelViewULoc, 1, GL_FALSE, glm::value_ptr(view * groundModel));
-        glUniformMatrix4fv(grassShader_.mvpULoc, 1, GL_FALSE, glm::value_ptr(projView * groundModel));
+        glUniformMatrix4fv(grassShader_.modelViewULoc, 1, GL_FALSE, glm::value_ptr(view * grassBladesModelMatrice_));
+        glUniformMatrix4fv(grassShader_.mvpULoc, 1, GL_FALSE, glm::value_ptr(projView * grassBladesModelMatrice_));
 
         glDisable(GL_CULL_FACE);
 
@@ -955,32 +1215,21 @@ struct App : public OpenGLApplication
         glEnable(GL_CULL_FACE);
         
         // Update particles
-        totalTime += deltaTime_;
-        timerParticles_ += deltaTime_;        
-        const float particlesSpawnInterval = 0.2f;
-        
-        unsigned int particlesToAdd = timerParticles_ / particlesSpawnInterval;
-        timerParticles_ -= particlesToAdd * particlesSpawnInterval;
-        
-        nParticles_ += particlesToAdd;
-        if (nParticles_ > MAX_PARTICLES_) nParticles_ = MAX_PARTICLES_;
-
-        particleComputeShader_.use();
-
         glm::vec3 exhaustPos = glm::vec3(car_.carModel * glm::vec4(2.0f, 0.24f, -0.43f, 1.0f));
         glm::vec3 exhaustDir = glm::normalize(glm::vec3(car_.carModel * glm::vec4(1.0f, 0.0f, 0.0f, 0.0f)));
-
-        glUniform1f(particleComputeShader_.timeULoc, totalTime);
-        glUniform1f(particleComputeShader_.deltaTimeULoc, deltaTime_);
-        glUniform3fv(particleComputeShader_.emitterPositionULoc, 1, glm::value_ptr(exhaustPos));
-        glUniform3fv(particleComputeShader_.emitterDirectionULoc, 1, glm::value_ptr(exhaustDir));
-
-        particles_[particleReadIdx_].setBindingIndex(0);
-        particles_[particleWriteIdx_].setBindingIndex(1);
-        
-        glDispatchCompute(1, 1, 1);
-        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT); 
+        particles_.setEmitter(exhaustEmitter_, exhaustPos, exhaustDir, exhaustRate_);
+        particles_.update(deltaTime_);
+
+        // Le tri n'est utile qu'à la fusion exacte, en pleine résolution.
+        ParticleShading particleShading = isSoftParticlesEnabled_ ? SOFT_PARTICLE_SHADING
+                                        : isParticleSortingEnabled_ ? SORTED_PARTICLE_SHADING
+                                        : OIT_PARTICLE_SHADING;
+        if (particleShading == SORTED_PARTICLE_SHADING)
+            particles_.sortByDepth(view, CAMERA_FAR);
         
+        // Tous les modèles qui suivent partagent le VAO du pool, lié une seule fois.
+        geometryPool_.bind();
+
         // Sky box
         glDepthFunc(GL_LEQUAL);
         skyShader_.use();
@@ -992,8 +1241,10 @@ struct App : public OpenGLApplication
         glDepthFunc(GL_LESS);
 
         // Sol sans contour
-        celShadingShader_.use();
-        drawGround(projView, view);
+        instancedCelShadingShader_.use();
+        instancedCelShadingShader_.setViewMatrices(projView, view);
+        lightClusters_.setShaderUniforms(instancedCelShadingShader_, viewportSize);
+        drawGround(OcclusionCuller::EARLY_PASS);
 
         // Objets avec contour
         glEnable(GL_STENCIL_TEST);
@@ -1002,85 +1253,80 @@ struct App : public OpenGLApplication
         glDepthMask(GL_TRUE);
 
         glStencilFunc(GL_ALWAYS, 1, 0xFF);
-        setMaterial(defaultMat);
-        carTexture_.use();
-        car_.draw(projView, view, false);
+        car_.draw();
 
         glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
         glDepthMask(GL_FALSE);
 
-        carWindowTexture_.use();
-        car_.drawWindows(projView, view);
+        car_.drawWindows();
         
         glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
         glDepthMask(GL_TRUE);
 
         glStencilFunc(GL_ALWAYS, 2, 0xFF);
-        setMaterial(grassMat);
-        treeTexture_.use();
-        drawTree(projView, view);
+        drawTree(OcclusionCuller::EARLY_PASS);
 
         glStencilFunc(GL_ALWAYS, 3, 0xFF);
-        setMaterial(streetlightMat);
-        drawStreetlights(projView, view);
+        drawStreetlights(OcclusionCuller::EARLY_PASS);
 
-        // effet de contour
-        glStencilMask(0x00);
-
-        edgeEffectShader_.use();
+        // Phase tardive: la profondeur de la phase précoce cache le reste.
+        if (isOcclusionCullingEnabled_)
+        {
+            occlusionCuller_.buildDepthPyramid(windowSize.x, windowSize.y);
+            occlusionCuller_.cullLate(frustum, view, proj, CAMERA_NEAR);
 
-        glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
-        car_.draw(projView, view, true);
+            instancedCelShadingShader_.use();
+            glStencilFunc(GL_ALWAYS, 0, 0xFF);
+            drawGround(OcclusionCuller::LATE_PASS);
 
-        glStencilFunc(GL_NOTEQUAL, 2, 0xFF);
-        drawTree(projView, view, true);
+            glStencilFunc(GL_ALWAYS, 2, 0xFF);
+            drawTree(OcclusionCuller::LATE_PASS);
 
-        glStencilFunc(GL_NOTEQUAL, 3, 0xFF);
-        drawStreetlights(projView, view, true);
+            glStencilFunc(GL_ALWAYS, 3, 0xFF);
+            drawStreetlights(OcclusionCuller::LATE_PASS);
+        }
 
-        glStencilMask(0xFF);
         glStencilFunc(GL_ALWAYS, 1, 0xFF);
-        glEnable(GL_DEPTH_TEST);
         glDisable(GL_STENCIL_TEST);
 
-        // Objets transparent
-        celShadingShader_.use();
+        // effet de contour, d'après les identifiants du stencil
+        outlinePass_.resolve(proj);
+
+        // Objets transparent, dans n'importe quel ordre
+        transparencyPass_.begin(outlinePass_.getDepthStencilTexture(), windowSize.x, windowSize.y);
+
+        geometryPool_.bind();
+        transparentCelShadingShader_.use();
+        transparentCelShadingShader_.setViewMatrices(projView, view);
+        lightClusters_.setShaderUniforms(transparentCelShadingShader_, viewportSize);
         setMaterial(windowMat);
-        carWindowTexture_.use();
-        car_.drawWindows(projView, view);
+        car_.drawWindows();
 
-        // Dessin particles
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        glDepthMask(GL_FALSE);
-            
-        particleDrawShader_.use();
-            
-        glUniformMatrix4fv(particleDrawShader_.projectionULoc, 1, GL_FALSE, glm::value_ptr(proj));
-        glUniformMatrix4fv(particleDrawShader_.modelViewULoc, 1, GL_FALSE, glm::value_ptr(view));
-        glUniform1i(particleDrawShader_.textureSamplerULoc, 0);
-            
-        smokeTexture_.use();
-        glBindVertexArray(vaoParticles_);
-            
-        particles_[particleReadIdx_].bindAsArray();
-            
-        GLsizei stride = sizeof(Particle);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Particle, position));
-        glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Particle, zOrientation));
-        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Particle, velocity));
-        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Particle, color));
-        glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Particle, size));
-        glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Particle, timeToLive));
-        glVertexAttribPointer(6, 1, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Particle, maxTimeToLive));
-            
-        glDrawArrays(GL_POINTS, 0, nParticles_);
-        glBindVertexArray(0);
-            
-        glDepthMask(GL_TRUE);
-        glDisable(GL_BLEND);
-            
-        std::swap(particleReadIdx_, particleWriteIdx_);
+        if (particleShading == OIT_PARTICLE_SHADING)
+        {
+            drawParticles(particleShading, proj, view);
+        }
+        else if (particleShading == SOFT_PARTICLE_SHADING)
+        {
+            // Dessinées à part, puis ajoutées aux mêmes cibles que les fenêtres
+            softParticlePass_.begin(outlinePass_.getDepthStencilTexture(), windowSize.x, windowSize.y, proj);
+            drawParticles(particleShading, proj, view);
+            transparencyPass_.resume();
+            softParticlePass_.resolve();
+        }
+
+        transparencyPass_.resolve();
+
+        // Particules triées: fusion exacte, par-dessus les autres objets transparents
+        if (particleShading == SORTED_PARTICLE_SHADING)
+        {
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            glDepthMask(GL_FALSE);
+            drawParticles(particleShading, proj, view);
+            glDepthMask(GL_TRUE);
+            glDisable(GL_BLEND);
+        }
     }
  
 private:
@@ -1103,54 +1349,104 @@ private:
     int numGrassVerts_ = 0;
     
     
-    GLuint vaoParticles_;
-    int particleReadIdx_ = 0;
-    int particleWriteIdx_ = 1;
+    // Bassin partagé par tous les émetteurs
+    static constexpr GLuint MAX_PARTICLES = 1 << 20;
+    ParticleSystem particles_;
+    ParticleSystem::EmitterHandle exhaustEmitter_;
+    // Particules par seconde
+    float exhaustRate_ = 40.0f;
+    int particleCountIndex_ = 0;
     
-    float totalTime;
-    float timerParticles_;
-    
-    static const unsigned int MAX_PARTICLES_ = 64;
-    unsigned int nParticles_;    
-    
-    ParticleComputeShader particleComputeShader_;
+    // Sans tri, les particules passent par TransparencyPass.
+    bool isParticleSortingEnabled_ = false;
     ParticleDrawShader particleDrawShader_;
+    SortedParticleDrawShader sortedParticleDrawShader_;
+    QuadParticleDrawShader quadParticleDrawShader_;
+    SortedQuadParticleDrawShader sortedQuadParticleDrawShader_;
+    SoftParticleDrawShader softParticleDrawShader_;
+    SoftQuadParticleDrawShader softQuadParticleDrawShader_;
+    ParticleDrawShader* particleDrawShaders_[N_PARTICLE_SHADINGS][ParticleSystem::N_DRAW_MODES] = {
+        {&particleDrawShader_, &quadParticleDrawShader_},
+        {&sortedParticleDrawShader_, &sortedQuadParticleDrawShader_},
+        {&softParticleDrawShader_, &softQuadParticleDrawShader_}
+    };
+    SoftParticlePass softParticlePass_;
+    bool isSoftParticlesEnabled_ = true;
+    // Distance de fondu devant les surfaces, en mètres
+    static constexpr float PARTICLE_SOFTNESS = 0.3f;
+    int particleDrawMode_ = ParticleSystem::INSTANCED_QUADS;
+    bool isParticleDrawBenchmarkEnabled_ = false;
+    int particleBenchmarkFrame_ = 0;
 
     Texture2D smokeTexture_;
-
-    ShaderStorageBuffer particles_[2];
     
-    static constexpr unsigned int N_STREET_PATCHES = 7*4+4;
-    glm::mat4 treeModelMatrice_;
+    // Transformations: objets statiques, puis zone réécrite à chaque image
+    static constexpr GLuint MAX_DYNAMIC_TRANSFORMS = 256;
+    TransformBuffer transforms_;
+    InstanceRange identityInstance_;
+    ShaderStorageBuffer materialTable_;
+    InstanceRange groundInstances_;
+    InstanceRange streetInstances_;
+    InstanceRange streetcornerInstances_;
+    InstanceRange treeInstances_;
+    InstanceRange streetlightInstances_;
+    InstanceRange streetlightLightInstances_;
+    // Indexés par instance statique
+    std::vector<BoundingSphere> staticInstanceSpheres_;
+    std::vector<uint8_t> staticInstanceVisibility_;
+    StaticBvh staticBvh_;
+    // Objet sélectionné à la souris
+    uint32_t pickedInstance_ = StaticBvh::INVALID_ITEM;
+    float pickedDistance_ = 0.0f;
+    
+    // Géométrie partagée et dessin indirect
+    static constexpr size_t GEOMETRY_POOL_VERTICES = 256 * 1024;
+    static constexpr size_t GEOMETRY_POOL_INDICES = 1024 * 1024;
+    GeometryPool geometryPool_;
+    DrawCommandBuffer drawCommands_{GL_STREAM_DRAW};
+    DrawCommandRange groundDraws_;
+    DrawCommandRange treeDraws_;
+    DrawCommandRange streetlightDraws_;
+
+    OcclusionCuller occlusionCuller_;
+    bool isOcclusionCullingEnabled_ = true;
+    DrawCommandRange occludedGroundDraws_;
+    DrawCommandRange occludedTreeDraws_;
+    DrawCommandRange occludedStreetlightDraws_;
+    
+    static constexpr int N_ROAD_SEGMENTS = 7;
+    static constexpr unsigned int N_ROAD_PATCHES = N_ROAD_SEGMENTS * 4;
+    static constexpr unsigned int N_STREET_PATCHES = N_ROAD_PATCHES + 4;
     glm::mat4 groundModelMatrice_;
+    glm::mat4 grassBladesModelMatrice_;
     glm::mat4 streetPatchesModelMatrices_[N_STREET_PATCHES];
     
     // Shaders
-    EdgeEffect edgeEffectShader_;
+    OutlinePass outlinePass_;
+    TransparencyPass transparencyPass_;
     CelShading celShadingShader_;
+    InstancedCelShading instancedCelShadingShader_;
+    TransparentCelShading transparentCelShadingShader_;
     Sky skyShader_;
     GrassShader grassShader_;
     
     // Textures
-    Texture2D grassTexture_;
-    Texture2D streetTexture_;
-    Texture2D streetcornerTexture_;
-    Texture2D carTexture_;
-    Texture2D carWindowTexture_;
-    Texture2D treeTexture_;
-    Texture2D streetlightTexture_;
-    Texture2D streetlightLightTexture_;
+    Texture2DArray materialTextures_[N_MATERIAL_TEXTURE_ARRAYS];
     TextureCubeMap skyboxTexture_;
     TextureCubeMap skyboxNightTexture_;
+    bool isDaySkyboxLoaded_ = false;
+    
+    AssetLoader assetLoader_;
+    TextureStreamer textureStreamer_;
     
     // Uniform buffers
+    static constexpr unsigned int MAX_MATERIAL_UPDATES_PER_FRAME = 32;
     UniformBuffer material_;
     UniformBuffer lights_;
 
-        struct {
-        DirectionalLight dirLight;
-        SpotLight spotLights[16];
-    } lightsData_;
+    DirectionalLight dirLight_;
+    
+    LightManager spotLights_;
     
     bool isDay_;
     
@@ -1164,18 +1460,51 @@ private:
     
     glm::vec3 cameraPosition_;
     glm::vec2 cameraOrientation_;
+    static constexpr float CAMERA_NEAR = 0.1f;
+    static constexpr float CAMERA_FAR = 300.0f;
+    static constexpr float CAMERA_FOV = 70.0f;
+    
+    LightClusters lightClusters_;
+    ShadowMaps shadowMaps_;
     
     static constexpr unsigned int N_TREES = 1;
     glm::mat4 treeModelMatrices_[N_TREES];
     static constexpr unsigned int N_STREETLIGHTS = 8;
     glm::mat4 streetlightModelMatrices_[N_STREETLIGHTS];
     glm::vec3 streetlightLightPositions[N_STREETLIGHTS];
+    LightManager::LightHandle streetlightLights_[N_STREETLIGHTS];
+    // Indexé par lampadaire, sur la position de sa lumière
+    StaticBvh streetlightBvh_;
+    // Les phares ont les tuiles 0 et 1 de l'atlas.
+    static constexpr GLuint STREETLIGHT_SHADOW_TILE = 2;
+    GLint shadowedStreetlight_ = -1;
+    static constexpr unsigned int N_CAR_LIGHTS = 4;
+    LightManager::LightHandle carLights_[N_CAR_LIGHTS];
     
     // Imgui var
     const char* const SCENE_NAMES[1] = {
         "Main scene"
     };
     const int N_SCENE_NAMES = sizeof(SCENE_NAMES) / sizeof(SCENE_NAMES[0]);
+    const char* const SHADOW_RESOLUTION_NAMES[4] = {
+        "512", "1024", "2048", "4096"
+    };
+    const GLsizei SHADOW_RESOLUTIONS[4] = {512, 1024, 2048, 4096};
+    const int N_SHADOW_RESOLUTIONS = sizeof(SHADOW_RESOLUTIONS) / sizeof(SHADOW_RESOLUTIONS[0]);
+    const char* const PARTICLE_DRAW_MODE_NAMES[ParticleSystem::N_DRAW_MODES] = {
+        "Geometry Shader", "Instanced Quads"
+    };
+    const char* const PARTICLE_RESOLUTION_NAMES[3] = {
+        "Full", "Half", "Quarter"
+    };
+    const int N_PARTICLE_RESOLUTIONS = sizeof(PARTICLE_RESOLUTION_NAMES) / sizeof(PARTICLE_RESOLUTION_NAMES[0]);
+
+    // Nombres de particules gardés fixes pour les mesures; 0 suit le débit d'échappement.
+    const GLuint PARTICLE_COUNTS[4] = {0, 10000, 100000, 1000000};
+    const char* const PARTICLE_COUNT_NAMES[4] = {
+        "Exhaust Rate", "10k", "100k", "1M"
+    };
+    const int N_PARTICLE_COUNTS = sizeof(PARTICLE_COUNT_NAMES) / sizeof(PARTICLE_COUNT_NAMES[0]);
     int currentScene_;
     
     bool isMouseMotionEnabled_;
@@ -0,0 +1,80 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include <glbinding/gl/gl.h>
+#include <glm/glm.hpp>
+
+using namespace gl;
+
+// Tableaux de textures des matériaux, un par taille de couche. Les .dds de
+// chaque couche sont produits à cette taille par compress_textures.
+enum MaterialTextureArray : GLint
+{
+    TEXTURES_2048,
+    TEXTURES_1024,
+    TEXTURES_64,
+    N_MATERIAL_TEXTURE_ARRAYS
+};
+
+struct MaterialTextureArrayDesc
+{
+    GLsizei size;
+    GLsizei nLayers;
+    GLenum internalFormat;
+};
+
+const MaterialTextureArrayDesc MATERIAL_TEXTURE_ARRAYS[N_MATERIAL_TEXTURE_ARRAYS] = {
+    {2048, 3, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT},
+    {1024, 2, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT},
+    {64, 2, GL_RGBA8},
+};
+
+// Unité du premier tableau, les suivants sont consécutifs. Doit correspondre à
+// materialSamplers des nuanceurs phong.
+const GLuint MATERIAL_TEXTURE_UNIT = 8;
+
+// Texture d'un matériau: le tableau dans les bits 8 et plus, la couche dans les bits 0 à 7.
+constexpr GLint materialTexture(MaterialTextureArray array, GLint layer)
+{
+    return (array << 8) | layer;
+}
+
+constexpr MaterialTextureArray getMaterialTextureArray(GLint texture)
+{
+    return (MaterialTextureArray)(texture >> 8);
+}
+
+constexpr GLint getMaterialTextureLayer(GLint texture)
+{
+    return texture & 0xFF;
+}
+
+enum MaterialLayer : GLint
+{
+    LAYER_CAR = materialTexture(TEXTURES_2048, 0),
+    LAYER_STREET = materialTexture(TEXTURES_2048, 1),
+    LAYER_STREETCORNER = materialTexture(TEXTURES_2048, 2),
+    LAYER_GRASS = materialTexture(TEXTURES_1024, 0),
+    LAYER_STREETLIGHT = materialTexture(TEXTURES_1024, 1),
+    LAYER_PINE = materialTexture(TEXTURES_64, 0),
+    LAYER_WINDOW = materialTexture(TEXTURES_64, 1),
+};
+
+// Doit correspondre au bloc std140 MaterialBlock des nuanceurs phong.
+struct Material
+{
+    glm::vec4 emission;
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec3 specular;
+    GLfloat shininess;
+
+    // materialTexture(tableau, couche)
+    GLint textureLayer;
+    // Les tableaux de textures répètent toujours; le nuanceur émule GL_CLAMP_TO_EDGE.
+    GLint isTextureClamped;
+    GLfloat textureLodBias;
+    GLfloat padding;
+};
+
+#endif // MATERIAL_H
@@ -0,0 +1,231 @@
+#include "mesh_cache.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+    #include <Windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+static const char MESH_CACHE_MAGIC[4] = {'M', 'C', 'H', 'E'};
+static const uint32_t MESH_CACHE_VERSION = 2;
+
+MeshCacheFile::MeshCacheFile()
+: data_(nullptr), size_(0)
+#ifdef _WIN32
+, fileHandle_(INVALID_HANDLE_VALUE), mappingHandle_(nullptr)
+#endif
+{
+}
+
+MeshCacheFile::MeshCacheFile(MeshCacheFile&& other)
+: MeshCacheFile()
+{
+    *this = std::move(other);
+}
+
+MeshCacheFile::~MeshCacheFile()
+{
+    close();
+}
+
+MeshCacheFile& MeshCacheFile::operator=(MeshCacheFile&& other)
+{
+    if (this == &other)
+        return *this;
+
+    close();
+    data_ = other.data_;
+    size_ = other.size_;
+    other.data_ = nullptr;
+    other.size_ = 0;
+#ifdef _WIN32
+    fileHandle_ = other.fileHandle_;
+    mappingHandle_ = other.mappingHandle_;
+    other.fileHandle_ = INVALID_HANDLE_VALUE;
+    other.mappingHandle_ = nullptr;
+#endif
+    return *this;
+}
+
+bool MeshCacheFile::open(const char* path, uint32_t expectedVertexStride)
+{
+    close();
+
+#ifdef _WIN32
+    fileHandle_ = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle_ == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(fileHandle_, &fileSize);
+    size_ = (size_t)fileSize.QuadPart;
+    if (size_ < sizeof(MeshCacheHeader))
+    {
+        close();
+        return false;
+    }
+
+    mappingHandle_ = CreateFileMappingA(fileHandle_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle_ != nullptr)
+        data_ = (const unsigned char*)MapViewOfFile(mappingHandle_, FILE_MAP_READ, 0, 0, 0);
+#else
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) == 0 && (size_t)fileStat.st_size >= sizeof(MeshCacheHeader))
+    {
+        size_ = (size_t)fileStat.st_size;
+        void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED)
+            data_ = (const unsigned char*)mapped;
+    }
+    ::close(fd);
+#endif
+
+    if (data_ == nullptr)
+    {
+        close();
+        return false;
+    }
+
+    const MeshCacheHeader& h = header();
+    size_t expectedSize = sizeof(MeshCacheHeader)
+                        + (size_t)h.vertexCount * h.vertexStride
+                        + (size_t)h.indexCount * sizeof(unsigned int);
+    bool isValid = std::memcmp(h.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) == 0
+                && h.version == MESH_CACHE_VERSION
+                && h.vertexStride == expectedVertexStride
+                && size_ == expectedSize;
+    if (!isValid)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MeshCacheFile::close()
+{
+#ifdef _WIN32
+    if (data_)
+        UnmapViewOfFile(data_);
+    if (mappingHandle_)
+        CloseHandle(mappingHandle_);
+    if (fileHandle_ != INVALID_HANDLE_VALUE)
+        CloseHandle(fileHandle_);
+    mappingHandle_ = nullptr;
+    fileHandle_ = INVALID_HANDLE_VALUE;
+#else
+    if (data_)
+        munmap((void*)data_, size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
+
+const MeshCacheHeader& MeshCacheFile::header() const
+{
+    return *(const MeshCacheHeader*)data_;
+}
+
+const void* MeshCacheFile::vertexData() const
+{
+    return data_ + sizeof(MeshCacheHeader);
+}
+
+const unsigned int* MeshCacheFile::indexData() const
+{
+    const MeshCacheHeader& h = header();
+    return (const unsigned int*)(data_ + sizeof(MeshCacheHeader) + (size_t)h.vertexCount * h.vertexStride);
+}
+
+
+std::string getMeshCachePath(const char* sourcePath)
+{
+    return std::string(sourcePath) + ".cache";
+}
+
+bool isMeshCacheUpToDate(const char* sourcePath, const char* cachePath)
+{
+    std::error_code error;
+    auto cacheTime = std::filesystem::last_write_time(cachePath, error);
+    if (error)
+        return false;
+
+    auto sourceTime = std::filesystem::last_write_time(sourcePath, error);
+    if (error)
+        return true;
+
+    return cacheTime >= sourceTime;
+}
+
+static void computeBounds(const void* vertexData, uint32_t vertexStride, uint32_t vertexCount, MeshCacheHeader& header)
+{
+    const unsigned char* vertices = (const unsigned char*)vertexData;
+    for (int j = 0; j < 3; j++)
+    {
+        header.boundsMin[j] = vertexCount > 0 ? INFINITY : 0.0f;
+        header.boundsMax[j] = vertexCount > 0 ? -INFINITY : 0.0f;
+    }
+    for (uint32_t i = 0; i < vertexCount; i++)
+    {
+        const float* position = (const float*)(vertices + (size_t)i * vertexStride);
+        for (int j = 0; j < 3; j++)
+        {
+            header.boundsMin[j] = std::min(header.boundsMin[j], position[j]);
+            header.boundsMax[j] = std::max(header.boundsMax[j], position[j]);
+        }
+    }
+
+    float radiusSquared = 0.0f;
+    for (uint32_t i = 0; i < vertexCount; i++)
+    {
+        const float* position = (const float*)(vertices + (size_t)i * vertexStride);
+        float distanceSquared = 0.0f;
+        for (int j = 0; j < 3; j++)
+        {
+            float d = position[j] - 0.5f * (header.boundsMin[j] + header.boundsMax[j]);
+            distanceSquared += d * d;
+        }
+        radiusSquared = std::max(radiusSquared, distanceSquared);
+    }
+    header.boundsRadius = std::sqrt(radiusSquared);
+}
+
+bool writeMeshCache(const char* cachePath, uint32_t attributeMask,
+                    const void* vertexData, uint32_t vertexStride, uint32_t vertexCount,
+                    const unsigned int* indexData, uint32_t indexCount)
+{
+    MeshCacheHeader header;
+    std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+    header.version = MESH_CACHE_VERSION;
+    header.attributeMask = attributeMask;
+    header.vertexStride = vertexStride;
+    header.vertexCount = vertexCount;
+    header.indexCount = indexCount;
+    computeBounds(vertexData, vertexStride, vertexCount, header);
+
+    std::ofstream file(cachePath, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cout << "Could not write mesh cache \"" << cachePath << "\"" << std::endl;
+        return false;
+    }
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)vertexData, (std::streamsize)vertexCount * vertexStride);
+    file.write((const char*)indexData, (std::streamsize)indexCount * sizeof(unsigned int));
+    return file.good();
+}
@@ -0,0 +1,69 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+
+// Attributs présents dans le tableau de sommets d'un fichier cache.
+enum MeshAttribute : uint32_t
+{
+    MESH_ATTRIBUTE_POSITION  = 1 << 0,
+    MESH_ATTRIBUTE_COLOR     = 1 << 1,
+    MESH_ATTRIBUTE_NORMAL    = 1 << 2,
+    MESH_ATTRIBUTE_TEXCOORDS = 1 << 3,
+};
+
+// Entête d'un fichier cache. Le tableau de sommets entrelacés suit directement
+// l'entête, puis le tableau d'indices (3 par triangle).
+struct MeshCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t attributeMask;
+    uint32_t vertexStride;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+
+    // Boîte englobante des positions, et rayon de la sphère centrée sur la boîte.
+    float boundsMin[3];
+    float boundsMax[3];
+    float boundsRadius;
+};
+
+class MeshCacheFile
+{
+public:
+    MeshCacheFile();
+    MeshCacheFile(MeshCacheFile&& other);
+    ~MeshCacheFile();
+
+    MeshCacheFile& operator=(MeshCacheFile&& other);
+
+    bool open(const char* path, uint32_t expectedVertexStride);
+    void close();
+
+    const MeshCacheHeader& header() const;
+    const void* vertexData() const;
+    const unsigned int* indexData() const;
+
+private:
+    const unsigned char* data_;
+    size_t size_;
+#ifdef _WIN32
+    void* fileHandle_;
+    void* mappingHandle_;
+#endif
+};
+
+std::string getMeshCachePath(const char* sourcePath);
+
+bool isMeshCacheUpToDate(const char* sourcePath, const char* cachePath);
+
+// La position (3 float) doit être au début de chaque sommet.
+bool writeMeshCache(const char* cachePath, uint32_t attributeMask,
+                    const void* vertexData, uint32_t vertexStride, uint32_t vertexCount,
+                    const unsigned int* indexData, uint32_t indexCount);
+
+#endif // MESH_CACHE_H
@@ -1,9 +1,18 @@
 #include "model.hpp"
 
+#include <cmath>
+#include <memory>
+#include <string>
+
 #include "happly.h"
+#include "asset_loader.hpp"
+#include "geometry_pool.hpp"
+#include "mesh_cache.hpp"
 
 using namespace gl;
 
+GeometryPool* Model::geometryPool_ = nullptr;
+
 struct Pos
 {
     GLfloat x;
@@ -25,41 +34,7 @@ struct Vertex
     Color color;
 };
 
-struct PositionAttribute
-{
-    float x, y, z;
-};
-
-struct ColorUCharAttribute
-{
-    unsigned char r, g, b;
-};
-
-struct NormalAttribute
-{
-    float x, y, z;
-};
-
-struct TexCoordAttribute
-{
-    float s, t;
-};
-
-struct VertexModel
-{
-    PositionAttribute pos;
-    ColorUCharAttribute color;
-    NormalAttribute normal;
-    TexCoordAttribute texCoord;
-};
-
-const GLuint VERTEX_POSITION_INDEX = 0;
-const GLuint VERTEX_COLOR_INDEX = 1;
-const GLuint VERTEX_NORMAL_INDEX = 2;
-const GLuint VERTEX_TEXCOORDS_INDEX = 3;
-
-
-void Model::load(const char* path)
+static bool buildMeshCache(const char* path, const char* cachePath)
 {
     happly::PLYData plyIn(path);
 
@@ -147,45 +122,63 @@ void Model::load(const char* path)
         }
     }
     
-    glGenBuffers(1, &vbo_);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    glBufferData(GL_ARRAY_BUFFER, vPos.size() * sizeof(VertexModel), &vPos[0], GL_STATIC_DRAW);
-    
-    glGenBuffers(1, &ebo_);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, elementsData.size() * sizeof(unsigned int), &elementsData[0], GL_STATIC_DRAW);
-    
-    glGenVertexArrays(1, &vao_);
-    glBindVertexArray(vao_);
-    
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);    
-    
-    glEnableVertexAttribArray(VERTEX_POSITION_INDEX);
-    glVertexAttribPointer(VERTEX_POSITION_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(VertexModel), (GLvoid*)(offsetof(VertexModel, pos)));        
-    
-    glEnableVertexAttribArray(VERTEX_COLOR_INDEX);
-    glVertexAttribPointer(VERTEX_COLOR_INDEX, 3, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(VertexModel), (GLvoid*)(offsetof(VertexModel, color)));
-    
+    uint32_t attributeMask = MESH_ATTRIBUTE_POSITION | MESH_ATTRIBUTE_COLOR;
     if (!normalX.empty())
-    {
-        glEnableVertexAttribArray(VERTEX_NORMAL_INDEX);
-        glVertexAttribPointer(VERTEX_NORMAL_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(VertexModel), (GLvoid*)(offsetof(VertexModel, normal)));
-    }
-    else
-        glDisableVertexAttribArray(VERTEX_NORMAL_INDEX);
-        
+        attributeMask |= MESH_ATTRIBUTE_NORMAL;
     if (!texCoordsX.empty())
+        attributeMask |= MESH_ATTRIBUTE_TEXCOORDS;
+
+    return writeMeshCache(cachePath, attributeMask,
+                          vPos.data(), sizeof(VertexModel), vPos.size(),
+                          elementsData.data(), elementsData.size());
+}
+
+static bool openMeshCache(const char* path, MeshCacheFile& cache)
+{
+    std::string cachePath = getMeshCachePath(path);
+
+    bool isCacheValid = isMeshCacheUpToDate(path, cachePath.c_str())
+                     && cache.open(cachePath.c_str(), sizeof(VertexModel));
+    if (!isCacheValid)
     {
-        glEnableVertexAttribArray(VERTEX_TEXCOORDS_INDEX);
-        glVertexAttribPointer(VERTEX_TEXCOORDS_INDEX, 2, GL_FLOAT, GL_FALSE, sizeof(VertexModel), (GLvoid*)(offsetof(VertexModel, texCoord)));
+        std::cout << "Building mesh cache for model \"" << path << "\"" << std::endl;
+        if (!buildMeshCache(path, cachePath.c_str()) || !cache.open(cachePath.c_str(), sizeof(VertexModel)))
+        {
+            std::cout << "Error loading model \"" << path << "\"" << std::endl;
+            return false;
+        }
     }
-    else
-        glDisableVertexAttribArray(VERTEX_TEXCOORDS_INDEX);
-    
-    glBindVertexArray(0);
-    
-    count_ = elementsData.size();
+    return true;
+}
+
+void Model::load(const char* path)
+{
+    MeshCacheFile cache;
+    if (openMeshCache(path, cache))
+        upload(cache);
+}
+
+void Model::load(const char* path, AssetLoader& loader)
+{
+    std::string pathStr = path;
+    loader.enqueue(pathStr, [this, pathStr]() -> AssetLoader::UploadFunction
+    {
+        auto cache = std::make_shared<MeshCacheFile>();
+        if (!openMeshCache(pathStr.c_str(), *cache))
+            return nullptr;
+        return [this, cache]() { upload(*cache); };
+    });
+}
+
+void Model::upload(const MeshCacheFile& cache)
+{
+    const MeshCacheHeader& header = cache.header();
+    upload((const VertexModel*)cache.vertexData(), header.vertexCount,
+           cache.indexData(), header.indexCount);
+
+    bounds_.min = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+    bounds_.max = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+    bounds_.sphere = {0.5f * (bounds_.min + bounds_.max), header.boundsRadius};
 }
 
 void Model::load(const float* vertexData, size_t vertexDataSize, const unsigned int* elementData, size_t elementDataSize)
@@ -212,47 +205,38 @@ void Model::load(const float* vertexData, size_t vertexDataSize, const unsigned
         vPos[i].texCoord.t = vertexData[i*5 + 4];
     }
     
-    glGenBuffers(1, &vbo_);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    glBufferData(GL_ARRAY_BUFFER, vPos.size() * sizeof(VertexModel), &vPos[0], GL_STATIC_DRAW);
-    
-    glGenBuffers(1, &ebo_);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, elementDataSize, elementData, GL_STATIC_DRAW);
-    
-    glGenVertexArrays(1, &vao_);
-    glBindVertexArray(vao_);
-    
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);    
-    
-    glEnableVertexAttribArray(VERTEX_POSITION_INDEX);
-    glVertexAttribPointer(VERTEX_POSITION_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(VertexModel), (GLvoid*)(offsetof(VertexModel, pos)));        
-    
-    glEnableVertexAttribArray(VERTEX_COLOR_INDEX);
-    glVertexAttribPointer(VERTEX_COLOR_INDEX, 3, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(VertexModel), (GLvoid*)(offsetof(VertexModel, color)));
+    upload(vPos.data(), vPos.size(), elementData, elementDataSize / sizeof(unsigned int));
 
-    glEnableVertexAttribArray(VERTEX_NORMAL_INDEX);
-    glVertexAttribPointer(VERTEX_NORMAL_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(VertexModel), (GLvoid*)(offsetof(VertexModel, normal)));
-        
-    glEnableVertexAttribArray(VERTEX_TEXCOORDS_INDEX);
-    glVertexAttribPointer(VERTEX_TEXCOORDS_INDEX, 2, GL_FLOAT, GL_FALSE, sizeof(VertexModel), (GLvoid*)(offsetof(VertexModel, texCoord)));
-    
-    glBindVertexArray(0);
-    
-    count_ = elementDataSize / sizeof(unsigned int);
+    bounds_.min = glm::vec3(INFINITY);
+    bounds_.max = glm::vec3(-INFINITY);
+    for (const VertexModel& vertex : vPos)
+    {
+        glm::vec3 position(vertex.pos.x, vertex.pos.y, vertex.pos.z);
+        bounds_.min = glm::min(bounds_.min, position);
+        bounds_.max = glm::max(bounds_.max, position);
+    }
+    bounds_.sphere = {0.5f * (bounds_.min + bounds_.max), 0.5f * glm::length(bounds_.max - bounds_.min)};
+}
+
+void Model::upload(const VertexModel* vertices, size_t nVertices, const unsigned int* elements, size_t nElements)
+{
+    mesh_ = geometryPool_->addMesh(vertices, nVertices, elements, nElements);
 }
 
-Model::~Model()
+void Model::setGeometryPool(GeometryPool* pool)
 {
-    glDeleteVertexArrays(1, &vao_);
-    glDeleteBuffers(1, &vbo_);
-    glDeleteBuffers(1, &ebo_);
+    geometryPool_ = pool;
 }
 
 void Model::draw()
 {
-    glBindVertexArray(vao_);
-    glDrawElements(GL_TRIANGLES, count_, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    glDrawElementsBaseVertex(GL_TRIANGLES, mesh_.count, GL_UNSIGNED_INT,
+                             (GLvoid*)(mesh_.firstIndex * sizeof(GLuint)), mesh_.baseVertex);
+}
+
+void Model::drawInstanced(GLsizei nInstances, GLuint baseInstance)
+{
+    glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, mesh_.count, GL_UNSIGNED_INT,
+                                                  (GLvoid*)(mesh_.firstIndex * sizeof(GLuint)),
+                                                  nInstances, mesh_.baseVertex, baseInstance);
 }
@@ -1,22 +1,106 @@
 #pragma once
 
+#include <cstdint>
+
 #include <glbinding/gl/gl.h>
+#include <glm/glm.hpp>
 
 using namespace gl;
 
+// Doit correspondre à la structure Instance (std430) des nuanceurs instanciés.
+struct InstanceData
+{
+    glm::mat4 model;
+    GLuint materialIndex;
+    GLuint padding[3];
+};
+
+struct PositionAttribute
+{
+    float x, y, z;
+};
+
+struct ColorUCharAttribute
+{
+    unsigned char r, g, b;
+};
+
+struct NormalAttribute
+{
+    float x, y, z;
+};
+
+struct TexCoordAttribute
+{
+    float s, t;
+};
+
+struct VertexModel
+{
+    PositionAttribute pos;
+    ColorUCharAttribute color;
+    NormalAttribute normal;
+    TexCoordAttribute texCoord;
+};
+
+// Position d'un modèle dans les tampons partagés du GeometryPool.
+struct MeshRange
+{
+    GLuint firstIndex;
+    GLsizei count;
+    GLint baseVertex;
+};
+
+// Plage d'instances d'un même modèle dans un tampon d'InstanceData.
+struct InstanceRange
+{
+    GLuint first;
+    GLsizei count;
+};
+
+struct BoundingSphere
+{
+    glm::vec3 center;
+    float radius;
+};
+
+// Volumes englobants d'un maillage, dans son repère local.
+struct MeshBounds
+{
+    glm::vec3 min;
+    glm::vec3 max;
+    BoundingSphere sphere;
+};
+
+class AssetLoader;
+class GeometryPool;
+class MeshCacheFile;
+
 class Model
 {
 public:
     void load(const char* path);
+    void load(const char* path, AssetLoader& loader);
     
-    ~Model();
-    
+    // Le VAO de GeometryPool doit être lié (GeometryPool::bind), une fois par passe.
     void draw();
+    // Dessine les instances [baseInstance, baseInstance + nInstances) du tampon d'instances lié.
+    void drawInstanced(GLsizei nInstances, GLuint baseInstance = 0);
     void load(const float* vertexData, size_t vertexDataSize, const unsigned int* elementData, size_t elementDataSize);
 
+    const MeshRange& mesh() const { return mesh_; }
+    const MeshBounds& bounds() const { return bounds_; }
+
+    // Tous les modèles sont sous-alloués dans ce pool; doit être défini avant le premier chargement.
+    static void setGeometryPool(GeometryPool* pool);
 
 private:
-    GLuint vao_, vbo_, ebo_;
-    GLsizei count_;
-};
+    void upload(const MeshCacheFile& cache);
+    void upload(const VertexModel* vertices, size_t nVertices, const unsigned int* elements, size_t nElements);
+
+private:
+    MeshRange mesh_ = {0, 0, 0};
+    MeshBounds bounds_ = {glm::vec3(0.0f), glm::vec3(0.0f), {glm::vec3(0.0f), 0.0f}};
 
+    static GeometryPool* geometryPool_;
+};
@@ -0,0 +1,185 @@
+#include "occlusion_culling.hpp"
+
+#include <algorithm>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "frustum_culling.hpp"
+
+// Unité de la pyramide dans les nuanceurs de calcul; 0 sert aux textures
+// ordinaires, 1 et 2 aux ombres, 4 à 7 aux passes plein écran et 8 à 10 aux
+// tableaux de matériaux (MATERIAL_TEXTURE_UNIT).
+static const GLuint PYRAMID_TEXTURE_UNIT = 3;
+static const GLuint WORKGROUP_SIZE = 64;
+static const GLuint PYRAMID_WORKGROUP_SIZE = 8;
+
+static GLsizei previousPowerOfTwo(GLsizei value)
+{
+    GLsizei result = 1;
+    while (result * 2 <= value)
+        result *= 2;
+    return result;
+}
+
+OcclusionCuller::OcclusionCuller()
+: groupStart_(0)
+, objectBindingIndex_(0), commandBuffer_(0), commandBindingIndex_(0)
+, depthTexture_(0), pyramidTexture_(0)
+, depthWidth_(0), depthHeight_(0)
+, pyramidWidth_(0), pyramidHeight_(0)
+, nPyramidLevels_(0)
+{
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+    glDeleteBuffers(1, &commandBuffer_);
+    glDeleteTextures(1, &depthTexture_);
+    glDeleteTextures(1, &pyramidTexture_);
+}
+
+void OcclusionCuller::init(GLuint objectBindingIndex, GLuint commandBindingIndex)
+{
+    objectBindingIndex_ = objectBindingIndex;
+    commandBindingIndex_ = commandBindingIndex;
+    pyramidShader_.create();
+    cullShader_.create();
+}
+
+void OcclusionCuller::reloadShaders()
+{
+    pyramidShader_.create();
+    cullShader_.create();
+}
+
+void OcclusionCuller::add(const Model& model, const InstanceRange& instances, const BoundingSphere* instanceSpheres)
+{
+    const MeshRange& mesh = model.mesh();
+    for (GLuint i = instances.first; i < instances.first + instances.count; i++)
+    {
+        CullObject object = {};
+        object.sphere = glm::vec4(instanceSpheres[i].center, instanceSpheres[i].radius);
+        object.command = {(GLuint)mesh.count, 1, mesh.firstIndex, mesh.baseVertex, i};
+        // Tout est considéré visible à la première image.
+        object.isVisible = 1;
+        objects_.push_back(object);
+    }
+}
+
+DrawCommandRange OcclusionCuller::endGroup()
+{
+    DrawCommandRange range = {groupStart_, (GLsizei)(objects_.size() - groupStart_)};
+    groupStart_ = objects_.size();
+    return range;
+}
+
+void OcclusionCuller::upload()
+{
+    objectBuffer_.allocate(objects_.data(), objects_.size() * sizeof(CullObject), GL_DYNAMIC_COPY);
+    objectBuffer_.setBindingIndex(objectBindingIndex_);
+
+    // Commandes de la phase précoce, puis de la phase tardive.
+    glGenBuffers(1, &commandBuffer_);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer_);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, N_PASSES * objects_.size() * sizeof(DrawElementsIndirectCommand),
+                 nullptr, GL_DYNAMIC_COPY);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, commandBindingIndex_, commandBuffer_);
+}
+
+void OcclusionCuller::cullEarly(const Frustum& frustum)
+{
+    dispatchCull(frustum, false);
+}
+
+void OcclusionCuller::buildDepthPyramid(GLsizei width, GLsizei height)
+{
+    if (width != depthWidth_ || height != depthHeight_)
+        allocateTextures(width, height);
+
+    glActiveTexture(GL_TEXTURE0 + PYRAMID_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, depthTexture_);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+
+    // Chaque niveau garde la profondeur la plus lointaine des texels qu'il couvre.
+    pyramidShader_.use();
+    GLsizei levelWidth = pyramidWidth_;
+    GLsizei levelHeight = pyramidHeight_;
+    for (GLint level = 0; level < nPyramidLevels_; level++)
+    {
+        glBindTexture(GL_TEXTURE_2D, level == 0 ? depthTexture_ : pyramidTexture_);
+        glUniform1i(pyramidShader_.sourceLevelULoc, level == 0 ? 0 : level - 1);
+        glBindImageTexture(0, pyramidTexture_, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+        glDispatchCompute((levelWidth + PYRAMID_WORKGROUP_SIZE - 1) / PYRAMID_WORKGROUP_SIZE,
+                          (levelHeight + PYRAMID_WORKGROUP_SIZE - 1) / PYRAMID_WORKGROUP_SIZE, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+        levelWidth = std::max(levelWidth / 2, 1);
+        levelHeight = std::max(levelHeight / 2, 1);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, pyramidTexture_);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void OcclusionCuller::cullLate(const Frustum& frustum, const glm::mat4& view, const glm::mat4& projection, float zNear)
+{
+    cullShader_.use();
+    glUniformMatrix4fv(cullShader_.viewULoc, 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(cullShader_.projectionULoc, 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform1f(cullShader_.zNearULoc, zNear);
+    glUniform2f(cullShader_.pyramidSizeULoc, pyramidWidth_, pyramidHeight_);
+    dispatchCull(frustum, true);
+}
+
+void OcclusionCuller::dispatchCull(const Frustum& frustum, bool isLatePass)
+{
+    cullShader_.use();
+    glUniform1ui(cullShader_.nObjectsULoc, objects_.size());
+    glUniform4fv(cullShader_.frustumPlanesULoc, Frustum::N_PLANES, glm::value_ptr(frustum.getPlanes()[0]));
+    glUniform1i(cullShader_.isLatePassULoc, isLatePass);
+
+    glDispatchCompute((objects_.size() + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void OcclusionCuller::draw(const DrawCommandRange& range, Pass pass)
+{
+    GLuint first = pass * objects_.size() + range.first;
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer_);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                (GLvoid*)(first * sizeof(DrawElementsIndirectCommand)),
+                                range.count, 0);
+}
+
+void OcclusionCuller::allocateTextures(GLsizei width, GLsizei height)
+{
+    depthWidth_ = width;
+    depthHeight_ = height;
+
+    glDeleteTextures(1, &depthTexture_);
+    glGenTextures(1, &depthTexture_);
+    glBindTexture(GL_TEXTURE_2D, depthTexture_);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+    // Puissance de deux inférieure à l'écran: chaque niveau fait exactement
+    // la moitié du précédent.
+    pyramidWidth_ = previousPowerOfTwo(width);
+    pyramidHeight_ = previousPowerOfTwo(height);
+    nPyramidLevels_ = 1;
+    while ((std::max(pyramidWidth_, pyramidHeight_) >> nPyramidLevels_) > 0)
+        nPyramidLevels_++;
+
+    // Stockage immuable: requis pour lier chaque niveau comme image.
+    glDeleteTextures(1, &pyramidTexture_);
+    glGenTextures(1, &pyramidTexture_);
+    glBindTexture(GL_TEXTURE_2D, pyramidTexture_);
+    glTexStorage2D(GL_TEXTURE_2D, nPyramidLevels_, GL_R32F, pyramidWidth_, pyramidHeight_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
@@ -0,0 +1,86 @@
+#ifndef OCCLUSION_CULLING_H
+#define OCCLUSION_CULLING_H
+
+#include <vector>
+
+#include <glbinding/gl/gl.h>
+#include <glm/glm.hpp>
+
+#include "geometry_pool.hpp"
+#include "model.hpp"
+#include "shaders.hpp"
+#include "shader_storage_buffer.hpp"
+
+using namespace gl;
+
+class Frustum;
+
+// Élimination des objets cachés sur le GPU, en deux phases. La phase précoce
+// dessine les objets visibles à l'image précédente; leur profondeur sert à
+// construire une pyramide de profondeurs maximales (Hi-Z). La phase tardive
+// teste ensuite toutes les sphères contre la pyramide et ne dessine que les
+// objets devenus visibles. Chaque instance a sa commande de dessin indirect,
+// dont le nuanceur de calcul met le nombre d'instances à 0 ou 1.
+class OcclusionCuller
+{
+public:
+    enum Pass
+    {
+        EARLY_PASS,
+        LATE_PASS,
+        N_PASSES
+    };
+
+    OcclusionCuller();
+    ~OcclusionCuller();
+
+    void init(GLuint objectBindingIndex, GLuint commandBindingIndex);
+    void reloadShaders();
+
+    // Comme DrawCommandBuffer::addVisible, instanceSpheres est indexé par
+    // l'indice absolu de l'instance.
+    void add(const Model& model, const InstanceRange& instances, const BoundingSphere* instanceSpheres);
+    DrawCommandRange endGroup();
+    // Après le dernier groupe; les objets sont ensuite fixes.
+    void upload();
+
+    void cullEarly(const Frustum& frustum);
+    // La profondeur de la phase précoce est lue dans le tampon de profondeur courant.
+    void buildDepthPyramid(GLsizei width, GLsizei height);
+    void cullLate(const Frustum& frustum, const glm::mat4& view, const glm::mat4& projection, float zNear);
+
+    // Le VAO de GeometryPool doit être lié.
+    void draw(const DrawCommandRange& range, Pass pass);
+
+private:
+    // Disposition std430 de CullObjectBlock.
+    struct CullObject
+    {
+        glm::vec4 sphere;
+        DrawElementsIndirectCommand command;
+        GLuint isVisible;
+        GLuint padding[2];
+    };
+
+    void allocateTextures(GLsizei width, GLsizei height);
+    void dispatchCull(const Frustum& frustum, bool isLatePass);
+
+private:
+    DepthPyramidShader pyramidShader_;
+    OcclusionCullShader cullShader_;
+
+    std::vector<CullObject> objects_;
+    GLuint groupStart_;
+    ShaderStorageBuffer objectBuffer_;
+    GLuint objectBindingIndex_;
+    GLuint commandBuffer_;
+    GLuint commandBindingIndex_;
+
+    GLuint depthTexture_;
+    GLuint pyramidTexture_;
+    GLsizei depthWidth_, depthHeight_;
+    GLsizei pyramidWidth_, pyramidHeight_;
+    GLint nPyramidLevels_;
+};
+
+#endif // OCCLUSION_CULLING_H
@@ -0,0 +1,137 @@
+#include "outline_pass.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "shaders/depth.h"
+
+// Unités des samplers de outline.fs; 0 sert aux textures ordinaires, 1 et 2
+// aux ombres, 3 à la pyramide de profondeur et 8 à 10 aux tableaux de
+// matériaux (MATERIAL_TEXTURE_UNIT).
+static const GLuint COLOR_TEXTURE_UNIT = 4;
+static const GLuint DEPTH_TEXTURE_UNIT = 5;
+static const GLuint STENCIL_TEXTURE_UNIT = 6;
+static const int MAX_THICKNESS = 8;
+
+// Bord relatif de profondeur linéaire au-delà duquel un contour est tracé
+// à l'intérieur d'un même objet.
+static const float DEPTH_EDGE_THRESHOLD = 0.1f;
+
+OutlinePass::OutlinePass()
+: framebuffer_(0), colorTexture_(0), depthStencilTexture_(0), stencilView_(0)
+, vao_(0), width_(0), height_(0), thickness_(2)
+{
+}
+
+OutlinePass::~OutlinePass()
+{
+    glDeleteFramebuffers(1, &framebuffer_);
+    glDeleteTextures(1, &colorTexture_);
+    glDeleteTextures(1, &depthStencilTexture_);
+    glDeleteTextures(1, &stencilView_);
+    glDeleteVertexArrays(1, &vao_);
+}
+
+void OutlinePass::init()
+{
+    shader_.create();
+    glGenFramebuffers(1, &framebuffer_);
+    // Le triangle plein écran est généré à partir de gl_VertexID.
+    glGenVertexArrays(1, &vao_);
+}
+
+void OutlinePass::reloadShader()
+{
+    shader_.create();
+}
+
+void OutlinePass::setThickness(int pixels)
+{
+    thickness_ = std::clamp(pixels, 0, MAX_THICKNESS);
+}
+
+int OutlinePass::getThickness() const
+{
+    return thickness_;
+}
+
+void OutlinePass::begin(GLsizei width, GLsizei height)
+{
+    if (width != width_ || height != height_)
+        allocateTextures(width, height);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+}
+
+void OutlinePass::resolve(const glm::mat4& projection)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glActiveTexture(GL_TEXTURE0 + COLOR_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, colorTexture_);
+    glActiveTexture(GL_TEXTURE0 + DEPTH_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, depthStencilTexture_);
+    glActiveTexture(GL_TEXTURE0 + STENCIL_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, stencilView_);
+    glActiveTexture(GL_TEXTURE0);
+
+    shader_.use();
+    glUniform1i(shader_.thicknessULoc, thickness_);
+    glUniform1f(shader_.depthEdgeThresholdULoc, DEPTH_EDGE_THRESHOLD);
+    glm::vec2 depthParams = getDepthParams(projection);
+    glUniform2f(shader_.depthParamsULoc, depthParams.x, depthParams.y);
+
+    // La profondeur de la scène est réécrite par gl_FragDepth.
+    glDepthFunc(GL_ALWAYS);
+    glDisable(GL_STENCIL_TEST);
+    glBindVertexArray(vao_);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glDepthFunc(GL_LESS);
+}
+
+GLuint OutlinePass::getDepthStencilTexture() const
+{
+    return depthStencilTexture_;
+}
+
+void OutlinePass::allocateTextures(GLsizei width, GLsizei height)
+{
+    width_ = width;
+    height_ = height;
+
+    // Stockage immuable: requis par glTextureView.
+    glDeleteTextures(1, &colorTexture_);
+    glDeleteTextures(1, &depthStencilTexture_);
+    glDeleteTextures(1, &stencilView_);
+    GLuint textures[3];
+    glGenTextures(3, textures);
+    colorTexture_ = textures[0];
+    depthStencilTexture_ = textures[1];
+    stencilView_ = textures[2];
+
+    glBindTexture(GL_TEXTURE_2D, colorTexture_);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glBindTexture(GL_TEXTURE_2D, depthStencilTexture_);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH24_STENCIL8, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glTextureView(stencilView_, GL_TEXTURE_2D, depthStencilTexture_, GL_DEPTH24_STENCIL8, 0, 1, 0, 1);
+    glBindTexture(GL_TEXTURE_2D, stencilView_);
+    glTexParameteri(GL_TEXTURE_2D, GL_DEPTH_STENCIL_TEXTURE_MODE, GL_STENCIL_INDEX);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorTexture_, 0);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, depthStencilTexture_, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "Outline framebuffer incomplete" << std::endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
@@ -0,0 +1,53 @@
+#ifndef OUTLINE_PASS_H
+#define OUTLINE_PASS_H
+
+#include <glbinding/gl/gl.h>
+#include <glm/glm.hpp>
+
+#include "shaders.hpp"
+
+using namespace gl;
+
+// Contours en espace écran. La scène opaque est dessinée dans un tampon
+// d'image hors écran dont le stencil contient l'identifiant de chaque objet
+// (0 pour les objets sans contour). Une passe plein écran recopie ensuite la
+// couleur et la profondeur dans le tampon par défaut, en traçant les contours
+// là où l'identifiant ou la profondeur change brusquement. L'épaisseur est en
+// pixels et ne dépend donc pas des maillages.
+class OutlinePass
+{
+public:
+    OutlinePass();
+    ~OutlinePass();
+
+    void init();
+    void reloadShader();
+
+    void setThickness(int pixels);
+    int getThickness() const;
+
+    // Lie le tampon hors écran et l'efface; les textures suivent la taille de la fenêtre.
+    void begin(GLsizei width, GLsizei height);
+    // Écrit la scène et ses contours dans le tampon par défaut, profondeur comprise,
+    // pour que les objets transparents puissent suivre.
+    void resolve(const glm::mat4& projection);
+
+    // Profondeur de la scène opaque, pour les passes qui suivent.
+    GLuint getDepthStencilTexture() const;
+
+private:
+    void allocateTextures(GLsizei width, GLsizei height);
+
+private:
+    OutlineShader shader_;
+    GLuint framebuffer_;
+    GLuint colorTexture_;
+    GLuint depthStencilTexture_;
+    // Vue du même stockage, lue comme stencil.
+    GLuint stencilView_;
+    GLuint vao_;
+    GLsizei width_, height_;
+    int thickness_;
+};
+
+#endif // OUTLINE_PASS_H
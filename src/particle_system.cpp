@@ -0,0 +1,268 @@
+#include "particle_system.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <numeric>
+
+typedef particle_layout::Counters Counters;
+typedef particle_layout::Emitter GpuEmitter;
+
+// Un nombre impair de passes de tri laisserait le résultat dans sortValues_.
+static const int N_SORT_PASSES = PARTICLE_SORT_KEY_BITS / PARTICLE_SORT_RADIX_BITS;
+static_assert(N_SORT_PASSES % 2 == 0, "The particle sort must end in the survivor list");
+
+// Étapes de particlesArguments.cs
+static const GLint ARGUMENTS_SIMULATE = 0;
+static const GLint ARGUMENTS_DRAW = 1;
+static const GLint ARGUMENTS_REFILL = 2;
+
+ParticleSystem::ParticleSystem()
+: capacity_(0), fixedCount_(0), time_(0.0f)
+, aliveListIndex_(0), counters_(0), vao_(0)
+{
+}
+
+ParticleSystem::~ParticleSystem()
+{
+    glDeleteBuffers(1, &counters_);
+    glDeleteVertexArrays(1, &vao_);
+}
+
+void ParticleSystem::init(GLuint capacity)
+{
+    capacity_ = capacity;
+
+    emitShader_.create();
+    refillShader_.create();
+    simulateShader_.create();
+    argumentsShader_.create();
+    sortHistogramShader_.create();
+    sortScanShader_.create();
+    sortScatterShader_.create();
+
+    positions_.allocate(nullptr, capacity * PARTICLE_POSITION_FLOATS * sizeof(GLfloat), GL_DYNAMIC_COPY);
+    motions_.allocate(nullptr, capacity * PARTICLE_MOTION_UINTS * sizeof(GLuint), GL_DYNAMIC_COPY);
+    lives_.allocate(nullptr, capacity * PARTICLE_LIFE_UINTS * sizeof(GLuint), GL_DYNAMIC_COPY);
+    aliveLists_[0].allocate(nullptr, capacity * sizeof(GLuint), GL_DYNAMIC_COPY);
+    aliveLists_[1].allocate(nullptr, capacity * sizeof(GLuint), GL_DYNAMIC_COPY);
+    emitterBuffer_.allocate(nullptr, MAX_EMITTERS * sizeof(GpuEmitter), GL_DYNAMIC_DRAW);
+
+    GLuint maxSortTiles = (capacity + PARTICLE_SORT_TILE_SIZE - 1) / PARTICLE_SORT_TILE_SIZE;
+    sortKeys_[0].allocate(nullptr, capacity * sizeof(GLuint), GL_DYNAMIC_COPY);
+    sortKeys_[1].allocate(nullptr, capacity * sizeof(GLuint), GL_DYNAMIC_COPY);
+    sortValues_.allocate(nullptr, capacity * sizeof(GLuint), GL_DYNAMIC_COPY);
+    sortHistogram_.allocate(nullptr, maxSortTiles * PARTICLE_SORT_BINS * sizeof(GLuint), GL_DYNAMIC_COPY);
+    sortHistogram_.setBindingIndex(PARTICLE_SORT_HISTOGRAM_BINDING);
+
+    // Au départ, toutes les particules sont libres.
+    std::vector<GLuint> deadList(capacity);
+    std::iota(deadList.begin(), deadList.end(), 0);
+    deadList_.allocate(deadList.data(), capacity * sizeof(GLuint), GL_DYNAMIC_COPY);
+
+    Counters counters = {};
+    counters.nDead = capacity;
+    counters.simulateGroups[1] = 1;
+    counters.simulateGroups[2] = 1;
+    counters.drawInstanceCount = 1;
+    counters.sortGroups[1] = 1;
+    counters.sortGroups[2] = 1;
+    counters.quadCount = 4;
+    counters.refillGroups[1] = 1;
+    counters.refillGroups[2] = 1;
+    glGenBuffers(1, &counters_);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, counters_);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(Counters), &counters, GL_DYNAMIC_COPY);
+
+    positions_.setBindingIndex(PARTICLE_POSITION_BINDING);
+    motions_.setBindingIndex(PARTICLE_MOTION_BINDING);
+    lives_.setBindingIndex(PARTICLE_LIFE_BINDING);
+    deadList_.setBindingIndex(PARTICLE_DEAD_LIST_BINDING);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PARTICLE_COUNTER_BINDING, counters_);
+    emitterBuffer_.setBindingIndex(PARTICLE_EMITTER_BINDING);
+    bindLists();
+
+    // Les particules sont lues dans les blocs de stockage: aucun attribut de sommet.
+    glGenVertexArrays(1, &vao_);
+}
+
+void ParticleSystem::reloadShaders()
+{
+    emitShader_.create();
+    refillShader_.create();
+    simulateShader_.create();
+    argumentsShader_.create();
+    sortHistogramShader_.create();
+    sortScanShader_.create();
+    sortScatterShader_.create();
+}
+
+GLuint ParticleSystem::getCapacity() const
+{
+    return capacity_;
+}
+
+void ParticleSystem::setFixedCount(GLuint count)
+{
+    fixedCount_ = std::min(count, capacity_);
+}
+
+GLuint ParticleSystem::getFixedCount() const
+{
+    return fixedCount_;
+}
+
+ParticleSystem::EmitterHandle ParticleSystem::addEmitter()
+{
+    if (emitters_.size() >= MAX_EMITTERS)
+    {
+        std::cout << "Too many particle emitters" << std::endl;
+        return MAX_EMITTERS - 1;
+    }
+    emitters_.push_back({glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f), 0.0f, 0.0f});
+    return emitters_.size() - 1;
+}
+
+void ParticleSystem::setEmitter(EmitterHandle emitter, const glm::vec3& position, const glm::vec3& direction, float rate)
+{
+    emitters_[emitter].position = position;
+    emitters_[emitter].direction = direction;
+    emitters_[emitter].rate = rate;
+}
+
+void ParticleSystem::bindLists()
+{
+    aliveLists_[aliveListIndex_].setBindingIndex(PARTICLE_ALIVE_LIST_BINDING);
+    aliveLists_[1 - aliveListIndex_].setBindingIndex(PARTICLE_SURVIVOR_LIST_BINDING);
+}
+
+void ParticleSystem::update(float deltaTime)
+{
+    time_ += deltaTime;
+
+    // Chaque émetteur reçoit une plage contiguë des fils de l'émission.
+    GpuEmitter gpuEmitters[MAX_EMITTERS];
+    GLuint nEmitted = 0;
+    for (size_t i = 0; i < emitters_.size(); i++)
+    {
+        Emitter& emitter = emitters_[i];
+        emitter.pending = fixedCount_ > 0 ? 0.0f : emitter.pending + emitter.rate * deltaTime;
+        GLuint count = (GLuint)std::floor(emitter.pending);
+        emitter.pending -= count;
+
+        gpuEmitters[i] = {glm::vec4(emitter.position, 1.0f), glm::vec4(emitter.direction, 0.0f), nEmitted, count, {}};
+        nEmitted += count;
+    }
+
+    // Les survivantes de l'image précédente deviennent la liste à simuler.
+    aliveListIndex_ = 1 - aliveListIndex_;
+    bindLists();
+
+    if (nEmitted > 0 || fixedCount_ > 0)
+        emitterBuffer_.updateData(gpuEmitters, 0, emitters_.size() * sizeof(GpuEmitter));
+
+    if (nEmitted > 0)
+    {
+        // Les particules de trop sont ignorées quand la liste morte est vide.
+        nEmitted = std::min(nEmitted, capacity_);
+
+        emitShader_.use();
+        glUniform1f(emitShader_.timeULoc, time_);
+        glUniform1ui(emitShader_.nEmittedULoc, nEmitted);
+        glUniform1ui(emitShader_.nEmittersULoc, emitters_.size());
+        glDispatchCompute((nEmitted + PARTICLE_WORKGROUP_SIZE - 1) / PARTICLE_WORKGROUP_SIZE, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    argumentsShader_.use();
+    glUniform1i(argumentsShader_.stageULoc, ARGUMENTS_SIMULATE);
+    glDispatchCompute(1, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+    simulateShader_.use();
+    glUniform1f(simulateShader_.deltaTimeULoc, deltaTime);
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, counters_);
+    glDispatchComputeIndirect(offsetof(Counters, simulateGroups));
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    if (fixedCount_ > 0 && !emitters_.empty())
+    {
+        argumentsShader_.use();
+        glUniform1i(argumentsShader_.stageULoc, ARGUMENTS_REFILL);
+        glUniform1ui(argumentsShader_.fixedCountULoc, fixedCount_);
+        glDispatchCompute(1, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+        refillShader_.use();
+        glUniform1f(refillShader_.timeULoc, time_);
+        glUniform1ui(refillShader_.nEmittersULoc, emitters_.size());
+        glDispatchComputeIndirect(offsetof(Counters, refillGroups));
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    argumentsShader_.use();
+    glUniform1i(argumentsShader_.stageULoc, ARGUMENTS_DRAW);
+    glDispatchCompute(1, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+}
+
+void ParticleSystem::sortByDepth(const glm::mat4& view, float maxDepth)
+{
+    sortTimer_.begin();
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, counters_);
+
+    // Passe paire: survivantes -> sortValues_; passe impaire: retour dans les survivantes.
+    ShaderStorageBuffer& survivors = aliveLists_[1 - aliveListIndex_];
+    for (int pass = 0; pass < N_SORT_PASSES; pass++)
+    {
+        bool isEven = pass % 2 == 0;
+        GLuint shift = pass * PARTICLE_SORT_RADIX_BITS;
+        sortKeys_[pass % 2].setBindingIndex(PARTICLE_SORT_KEYS_IN_BINDING);
+        sortKeys_[1 - pass % 2].setBindingIndex(PARTICLE_SORT_KEYS_OUT_BINDING);
+        (isEven ? survivors : sortValues_).setBindingIndex(PARTICLE_SORT_VALUES_IN_BINDING);
+        (isEven ? sortValues_ : survivors).setBindingIndex(PARTICLE_SORT_VALUES_OUT_BINDING);
+
+        sortHistogramShader_.use();
+        glUniform1ui(sortHistogramShader_.shiftULoc, shift);
+        glUniform1i(sortHistogramShader_.computeKeysULoc, pass == 0);
+        glUniformMatrix4fv(sortHistogramShader_.viewULoc, 1, GL_FALSE, &view[0][0]);
+        glUniform1f(sortHistogramShader_.maxDepthULoc, maxDepth);
+        glDispatchComputeIndirect(offsetof(Counters, sortGroups));
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        sortScanShader_.use();
+        glDispatchCompute(1, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        sortScatterShader_.use();
+        glUniform1ui(sortScatterShader_.shiftULoc, shift);
+        glDispatchComputeIndirect(offsetof(Counters, sortGroups));
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    sortTimer_.end();
+}
+
+float ParticleSystem::getLastSortTime() const
+{
+    return sortTimer_.getLastTime();
+}
+
+void ParticleSystem::draw(DrawMode mode)
+{
+    drawTimers_[mode].begin();
+    glBindVertexArray(vao_);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, counters_);
+    if (mode == INSTANCED_QUADS)
+        glDrawArraysIndirect(GL_TRIANGLE_STRIP, (GLvoid*)offsetof(Counters, quadCount));
+    else
+        glDrawArraysIndirect(GL_POINTS, (GLvoid*)offsetof(Counters, drawCount));
+    glBindVertexArray(0);
+    drawTimers_[mode].end();
+}
+
+float ParticleSystem::getLastDrawTime(DrawMode mode) const
+{
+    return drawTimers_[mode].getLastTime();
+}
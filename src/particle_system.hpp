@@ -0,0 +1,120 @@
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+
+#include <vector>
+
+#include <glbinding/gl/gl.h>
+#include <glm/glm.hpp>
+
+#include "gpu_timer.hpp"
+#include "shaders.hpp"
+#include "shader_storage_buffer.hpp"
+
+using namespace gl;
+
+#include "shaders/particleLayout.h"
+
+// Particules entièrement gérées sur le GPU, dans un bassin de taille fixe
+// partagé par tous les émetteurs. Les indices libres sont dans une liste de
+// particules mortes; les vivantes sont dans une liste compacte, réécrite à
+// chaque image par la simulation avec les seules survivantes. Les compteurs
+// sont incrémentés atomiquement par les nuanceurs, qui écrivent aussi les
+// arguments des dispatch et du dessin indirects: le CPU ne lit jamais rien.
+// Les blocs et leur disposition sont décrits dans shaders/particleLayout.h.
+class ParticleSystem
+{
+public:
+    typedef GLuint EmitterHandle;
+
+    static constexpr GLuint MAX_EMITTERS = 16;
+
+    enum DrawMode
+    {
+        // Un point par particule, agrandi en quadrilatère par particlesDraw.gs.
+        GEOMETRY_SHADER_POINTS,
+        // Une instance de 4 sommets par particule, sans nuanceur de géométrie.
+        INSTANCED_QUADS,
+        N_DRAW_MODES
+    };
+
+    ParticleSystem();
+    ~ParticleSystem();
+
+    void init(GLuint capacity);
+    void reloadShaders();
+
+    GLuint getCapacity() const;
+
+    EmitterHandle addEmitter();
+    // rate en particules par seconde; la direction est celle de l'éjection.
+    void setEmitter(EmitterHandle emitter, const glm::vec3& position, const glm::vec3& direction, float rate);
+
+    // Pour les mesures: 0 rend le contrôle aux débits des émetteurs. Sinon, les
+    // débits sont ignorés et les mortes sont remplacées après chaque simulation,
+    // ce qui garde exactement count particules à dessiner (au plus la capacité).
+    void setFixedCount(GLuint count);
+    GLuint getFixedCount() const;
+
+    // Émission, puis simulation et compaction des particules vivantes.
+    void update(float deltaTime);
+    // Tri par base des survivantes de l'arrière vers l'avant, après update(),
+    // pour un dessin avec fusion alpha ordinaire. maxDepth borne la profondeur
+    // en vue quantifiée dans les clés.
+    void sortByDepth(const glm::mat4& view, float maxDepth);
+    // Durée GPU du dernier tri mesurée, en millisecondes.
+    float getLastSortTime() const;
+    // Dessine les survivantes avec le nuanceur déjà lié, qui doit correspondre
+    // au mode; il lit les blocs de particules et SurvivorListBlock.
+    void draw(DrawMode mode);
+    // Durée GPU du dernier dessin mesurée dans ce mode, en millisecondes.
+    float getLastDrawTime(DrawMode mode) const;
+
+private:
+    struct Emitter
+    {
+        glm::vec3 position;
+        glm::vec3 direction;
+        float rate;
+        // Fraction de particule reportée à l'image suivante.
+        float pending;
+    };
+
+    void bindLists();
+
+private:
+    ParticleEmitShader emitShader_;
+    ParticleRefillShader refillShader_;
+    ParticleSimulateShader simulateShader_;
+    ParticleArgumentsShader argumentsShader_;
+    ParticleSortHistogramShader sortHistogramShader_;
+    ParticleSortScanShader sortScanShader_;
+    ParticleSortScatterShader sortScatterShader_;
+
+    GLuint capacity_;
+    GLuint fixedCount_;
+    float time_;
+
+    ShaderStorageBuffer positions_;
+    ShaderStorageBuffer motions_;
+    ShaderStorageBuffer lives_;
+    ShaderStorageBuffer deadList_;
+    // Survivantes de l'image précédente et nouvelles particules, puis
+    // survivantes de la simulation; échangées à chaque image.
+    ShaderStorageBuffer aliveLists_[2];
+    int aliveListIndex_;
+    GLuint counters_;
+    ShaderStorageBuffer emitterBuffer_;
+
+    // Clés des deux passes du tri et indices de la passe intermédiaire.
+    ShaderStorageBuffer sortKeys_[2];
+    ShaderStorageBuffer sortValues_;
+    ShaderStorageBuffer sortHistogram_;
+
+    GpuTimer sortTimer_;
+    GpuTimer drawTimers_[N_DRAW_MODES];
+
+    std::vector<Emitter> emitters_;
+    GLuint vao_;
+};
+
+#endif // PARTICLE_SYSTEM_H
@@ -1,6 +1,7 @@
 #include "shader_program.hpp"
 
 #include <iostream>
+#include <sstream>
 
 #include <inf2705/utils.hpp>
 
@@ -93,9 +94,53 @@ void ShaderProgram::use()
 
 
 
+// Remplace les lignes #include "fichier" par le contenu du fichier, cherché à
+// côté du nuanceur qui l'inclut. Les fichiers inclus se protègent eux-mêmes
+// contre l'inclusion multiple avec #ifndef.
+static std::string expandIncludes(const std::string& code, const std::string& path, int depth = 0)
+{
+    const int MAX_INCLUDE_DEPTH = 8;
+    const std::string INCLUDE_DIRECTIVE = "#include";
+
+    size_t slashPos = path.find_last_of("/\\");
+    std::string directory = slashPos == std::string::npos ? "" : path.substr(0, slashPos + 1);
+
+    std::istringstream lines(code);
+    std::string expanded;
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        size_t directivePos = line.find_first_not_of(" \t");
+        if (directivePos == std::string::npos || line.compare(directivePos, INCLUDE_DIRECTIVE.size(), INCLUDE_DIRECTIVE) != 0)
+        {
+            expanded += line + '\n';
+            continue;
+        }
+
+        size_t nameBegin = line.find('"', directivePos);
+        size_t nameEnd = nameBegin == std::string::npos ? nameBegin : line.find('"', nameBegin + 1);
+        if (nameEnd == std::string::npos || depth >= MAX_INCLUDE_DEPTH)
+        {
+            std::cout << "Invalid #include in \"" << path << "\": " << line << std::endl;
+            continue;
+        }
+
+        std::string includePath = directory + line.substr(nameBegin + 1, nameEnd - nameBegin - 1);
+        expanded += expandIncludes(readFile(includePath.c_str()), includePath, depth + 1);
+    }
+    return expanded;
+}
+
 void ShaderProgram::loadShaderSource(GLenum type, const char* path)
 {
-    std::string code = readFile(path);
+    std::string code = expandIncludes(readFile(path), path);
+    if (!defines_.empty())
+    {
+        size_t versionPos = code.find("#version");
+        size_t insertPos = versionPos == std::string::npos ? 0 : code.find('\n', versionPos);
+        insertPos = insertPos == std::string::npos ? code.size() : insertPos + 1;
+        code.insert(insertPos, defines_);
+    }
     GLuint shaderObject = glCreateShader(type);
     const char* codePtr = code.c_str();
     glShaderSource(shaderObject, 1, &codePtr, NULL);
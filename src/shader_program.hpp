@@ -1,6 +1,10 @@
+#ifndef SHADER_PROGRAM_H
+#define SHADER_PROGRAM_H
+
 #include <glbinding/gl/gl.h>
 using namespace gl;
 
+#include <string>
 #include <unordered_map>
 
 
@@ -28,6 +32,9 @@ protected:
 protected:
     GLuint id_;
     const char* name_;
+    // Insérées après la ligne #version de chaque source (ex. "#define INSTANCED\n").
+    std::string defines_;
     std::unordered_map<std::string, GLuint> shaderSourcesCompiled_;
 };
 
+#endif // SHADER_PROGRAM_H
@@ -1,6 +1,7 @@
 #include "shader_storage_buffer.hpp"
 
 ShaderStorageBuffer::ShaderStorageBuffer()
+: id_(0)
 {
 }
 
@@ -16,9 +17,11 @@ ShaderStorageBuffer::~ShaderStorageBuffer()
     glDeleteBuffers(1, &id_);
 }
 
+// Réallouer garde le même tampon, donc ses points de liaison restent valides.
 void ShaderStorageBuffer::allocate(const void* data, GLsizeiptr byteSize, GLenum usage)
 {
-    glGenBuffers(1, &id_);
+    if (!id_)
+        glGenBuffers(1, &id_);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, id_);
     glBufferData(GL_SHADER_STORAGE_BUFFER, byteSize, data, usage);
 }
@@ -3,21 +3,22 @@
 #include <glm/gtc/type_ptr.hpp>
 
 
-void EdgeEffect::load()
+void OutlineShader::load()
 {
-    const char* VERTEX_SRC_PATH = "./shaders/edge.vs.glsl";
-    const char* FRAGMENT_SRC_PATH = "./shaders/edge.fs.glsl";
+    const char* VERTEX_SRC_PATH = "./shaders/fullscreen.vs.glsl";
+    const char* FRAGMENT_SRC_PATH = "./shaders/outline.fs.glsl";
     
-    name_ = "EdgeEffect";
+    name_ = "Outline";
     loadShaderSource(GL_VERTEX_SHADER, VERTEX_SRC_PATH);
     loadShaderSource(GL_FRAGMENT_SHADER, FRAGMENT_SRC_PATH);
     link();
 }
 
-void EdgeEffect::getAllUniformLocations()
+void OutlineShader::getAllUniformLocations()
 {
-    mvpULoc = glGetUniformLocation(id_, "mvp");
-    colorULoc = glGetUniformLocation(id_, "color");
+    thicknessULoc = glGetUniformLocation(id_, "thickness");
+    depthEdgeThresholdULoc = glGetUniformLocation(id_, "depthEdgeThreshold");
+    depthParamsULoc = glGetUniformLocation(id_, "depthParams");
 }
 
 
@@ -51,31 +52,130 @@ void CelShading::load()
 
 void CelShading::getAllUniformLocations()
 {
-    mvpULoc = glGetUniformLocation(id_, "mvp");
+    projViewULoc = glGetUniformLocation(id_, "projView");
     viewULoc = glGetUniformLocation(id_, "view");
-    modelViewULoc = glGetUniformLocation(id_, "modelView");
-    normalULoc = glGetUniformLocation(id_, "normalMatrix");
-    
-    nSpotLightsULoc = glGetUniformLocation(id_, "nSpotLights");
     
     globalAmbientULoc = glGetUniformLocation(id_, "globalAmbient");
+    
+    clusterGridSizeULoc = glGetUniformLocation(id_, "clusterGridSize");
+    clusterTileSizeULoc = glGetUniformLocation(id_, "clusterTileSize");
+    clusterDepthParamsULoc = glGetUniformLocation(id_, "clusterDepthParams");
 }
 
 void CelShading::assignAllUniformBlockIndexes()
 {
     setUniformBlockBinding("MaterialBlock", 0);
     setUniformBlockBinding("LightingBlock", 1);
+    setUniformBlockBinding("ShadowBlock", 2);
 }
 
 
-void CelShading::setMatrices(const glm::mat4& mvp, const glm::mat4& view, const glm::mat4& model)
+void CelShading::setViewMatrices(const glm::mat4& projView, const glm::mat4& view)
 {
-    glm::mat4 modelView = view * model;
-    
+    glUniformMatrix4fv(projViewULoc, 1, GL_FALSE, &projView[0][0]);
     glUniformMatrix4fv(viewULoc, 1, GL_FALSE, &view[0][0]);
-    glUniformMatrix4fv(mvpULoc, 1, GL_FALSE, &mvp[0][0]);
-    glUniformMatrix4fv(modelViewULoc, 1, GL_FALSE, &modelView[0][0]);
-    glUniformMatrix3fv(normalULoc, 1, GL_TRUE, glm::value_ptr(glm::inverse(glm::mat3(modelView))));
+}
+
+void InstancedCelShading::load()
+{
+    const char* VERTEX_SRC_PATH = "./shaders/phong.vs.glsl";
+    const char* FRAGMENT_SRC_PATH = "./shaders/phong.fs.glsl";
+    
+    name_ = "InstancedCelShading";
+    defines_ = "#define MATERIAL_TABLE\n";
+    loadShaderSource(GL_VERTEX_SHADER, VERTEX_SRC_PATH);
+    loadShaderSource(GL_FRAGMENT_SHADER, FRAGMENT_SRC_PATH);
+    link();
+}
+
+void InstancedCelShading::assignAllUniformBlockIndexes()
+{
+    // Les matériaux sont dans un tampon de stockage, pas dans MaterialBlock.
+    setUniformBlockBinding("LightingBlock", 1);
+    setUniformBlockBinding("ShadowBlock", 2);
+}
+
+void TransparentCelShading::load()
+{
+    const char* VERTEX_SRC_PATH = "./shaders/phong.vs.glsl";
+    const char* FRAGMENT_SRC_PATH = "./shaders/phong.fs.glsl";
+    
+    name_ = "TransparentCelShading";
+    defines_ = "#define WEIGHTED_OIT\n";
+    loadShaderSource(GL_VERTEX_SHADER, VERTEX_SRC_PATH);
+    loadShaderSource(GL_FRAGMENT_SHADER, FRAGMENT_SRC_PATH);
+    link();
+}
+
+void TransparencyComposite::load()
+{
+    name_ = "TransparencyComposite";
+    loadShaderSource(GL_VERTEX_SHADER, "./shaders/fullscreen.vs.glsl");
+    loadShaderSource(GL_FRAGMENT_SHADER, "./shaders/transparencyComposite.fs.glsl");
+    link();
+}
+
+void TransparencyComposite::getAllUniformLocations()
+{
+}
+
+void ShadowDepth::load()
+{
+    name_ = "ShadowDepth";
+    loadShaderSource(GL_VERTEX_SHADER, "./shaders/shadowDepth.vs.glsl");
+    link();
+}
+
+void ShadowDepth::getAllUniformLocations()
+{
+    lightProjViewULoc = glGetUniformLocation(id_, "lightProjView");
+}
+
+void LightClusterShader::load()
+{
+    name_ = "LightClusters";
+    loadShaderSource(GL_COMPUTE_SHADER, "./shaders/lightClusters.cs.glsl");
+    link();
+}
+
+void LightClusterShader::getAllUniformLocations()
+{
+    viewULoc = glGetUniformLocation(id_, "view");
+    nSpotLightsULoc = glGetUniformLocation(id_, "nSpotLights");
+    clusterGridSizeULoc = glGetUniformLocation(id_, "clusterGridSize");
+    projScaleULoc = glGetUniformLocation(id_, "projScale");
+    zNearULoc = glGetUniformLocation(id_, "zNear");
+    zFarULoc = glGetUniformLocation(id_, "zFar");
+}
+
+void DepthPyramidShader::load()
+{
+    name_ = "DepthPyramid";
+    loadShaderSource(GL_COMPUTE_SHADER, "./shaders/depthPyramid.cs.glsl");
+    link();
+}
+
+void DepthPyramidShader::getAllUniformLocations()
+{
+    sourceLevelULoc = glGetUniformLocation(id_, "sourceLevel");
+}
+
+void OcclusionCullShader::load()
+{
+    name_ = "OcclusionCull";
+    loadShaderSource(GL_COMPUTE_SHADER, "./shaders/occlusionCull.cs.glsl");
+    link();
+}
+
+void OcclusionCullShader::getAllUniformLocations()
+{
+    nObjectsULoc = glGetUniformLocation(id_, "nObjects");
+    frustumPlanesULoc = glGetUniformLocation(id_, "frustumPlanes");
+    isLatePassULoc = glGetUniformLocation(id_, "isLatePass");
+    viewULoc = glGetUniformLocation(id_, "view");
+    projectionULoc = glGetUniformLocation(id_, "projection");
+    zNearULoc = glGetUniformLocation(id_, "zNear");
+    pyramidSizeULoc = glGetUniformLocation(id_, "pyramidSize");
 }
 
 void GrassShader::load() {
@@ -94,21 +194,81 @@ void GrassShader::getAllUniformLocations() {
     modelViewULoc = glGetUniformLocation(id_, "modelView");
 }
 
-void ParticleComputeShader::load() {
-    name_ = "ParticleCompute";
-    loadShaderSource(GL_COMPUTE_SHADER, "./shaders/particlesUpdate.cs.glsl");
+void ParticleEmitShader::load() {
+    name_ = "ParticleEmit";
+    loadShaderSource(GL_COMPUTE_SHADER, "./shaders/particlesEmit.cs.glsl");
     link();
 }
 
-void ParticleComputeShader::getAllUniformLocations() {
+void ParticleEmitShader::getAllUniformLocations() {
     timeULoc = glGetUniformLocation(id_, "time");
+    nEmittedULoc = glGetUniformLocation(id_, "nEmitted");
+    nEmittersULoc = glGetUniformLocation(id_, "nEmitters");
+}
+
+void ParticleRefillShader::load() {
+    name_ = "ParticleRefill";
+    defines_ = "#define REFILL\n";
+    loadShaderSource(GL_COMPUTE_SHADER, "./shaders/particlesEmit.cs.glsl");
+    link();
+}
+
+void ParticleSimulateShader::load() {
+    name_ = "ParticleSimulate";
+    loadShaderSource(GL_COMPUTE_SHADER, "./shaders/particlesSimulate.cs.glsl");
+    link();
+}
+
+void ParticleSimulateShader::getAllUniformLocations() {
     deltaTimeULoc = glGetUniformLocation(id_, "deltaTime");
-    emitterPositionULoc = glGetUniformLocation(id_, "emitterPosition");
-    emitterDirectionULoc = glGetUniformLocation(id_, "emitterDirection");
+}
+
+void ParticleArgumentsShader::load() {
+    name_ = "ParticleArguments";
+    loadShaderSource(GL_COMPUTE_SHADER, "./shaders/particlesArguments.cs.glsl");
+    link();
+}
+
+void ParticleArgumentsShader::getAllUniformLocations() {
+    stageULoc = glGetUniformLocation(id_, "stage");
+    fixedCountULoc = glGetUniformLocation(id_, "fixedCount");
+}
+
+void ParticleSortHistogramShader::load() {
+    name_ = "ParticleSortHistogram";
+    loadShaderSource(GL_COMPUTE_SHADER, "./shaders/particlesSortHistogram.cs.glsl");
+    link();
+}
+
+void ParticleSortHistogramShader::getAllUniformLocations() {
+    shiftULoc = glGetUniformLocation(id_, "shift");
+    computeKeysULoc = glGetUniformLocation(id_, "computeKeys");
+    viewULoc = glGetUniformLocation(id_, "view");
+    maxDepthULoc = glGetUniformLocation(id_, "maxDepth");
+}
+
+void ParticleSortScanShader::load() {
+    name_ = "ParticleSortScan";
+    loadShaderSource(GL_COMPUTE_SHADER, "./shaders/particlesSortScan.cs.glsl");
+    link();
+}
+
+void ParticleSortScanShader::getAllUniformLocations() {
+}
+
+void ParticleSortScatterShader::load() {
+    name_ = "ParticleSortScatter";
+    loadShaderSource(GL_COMPUTE_SHADER, "./shaders/particlesSortScatter.cs.glsl");
+    link();
+}
+
+void ParticleSortScatterShader::getAllUniformLocations() {
+    shiftULoc = glGetUniformLocation(id_, "shift");
 }
 
 void ParticleDrawShader::load() {
     name_ = "ParticleDraw";
+    defines_ = "#define WEIGHTED_OIT\n";
     loadShaderSource(GL_VERTEX_SHADER, "./shaders/particlesDraw.vs.glsl");
     loadShaderSource(GL_GEOMETRY_SHADER, "./shaders/particlesDraw.gs.glsl");
     loadShaderSource(GL_FRAGMENT_SHADER, "./shaders/particlesDraw.fs.glsl");
@@ -119,4 +279,71 @@ void ParticleDrawShader::getAllUniformLocations() {
     projectionULoc = glGetUniformLocation(id_, "projection");
     modelViewULoc = glGetUniformLocation(id_, "modelView");
     textureSamplerULoc = glGetUniformLocation(id_, "textureSampler");
+    depthParamsULoc = glGetUniformLocation(id_, "depthParams");
+    softnessULoc = glGetUniformLocation(id_, "softness");
+}
+
+void SortedParticleDrawShader::load() {
+    name_ = "SortedParticleDraw";
+    loadShaderSource(GL_VERTEX_SHADER, "./shaders/particlesDraw.vs.glsl");
+    loadShaderSource(GL_GEOMETRY_SHADER, "./shaders/particlesDraw.gs.glsl");
+    loadShaderSource(GL_FRAGMENT_SHADER, "./shaders/particlesDraw.fs.glsl");
+    link();
+}
+
+void QuadParticleDrawShader::load() {
+    name_ = "QuadParticleDraw";
+    defines_ = "#define WEIGHTED_OIT\n#define INSTANCED_QUADS\n";
+    loadShaderSource(GL_VERTEX_SHADER, "./shaders/particlesDraw.vs.glsl");
+    loadShaderSource(GL_FRAGMENT_SHADER, "./shaders/particlesDraw.fs.glsl");
+    link();
+}
+
+void SortedQuadParticleDrawShader::load() {
+    name_ = "SortedQuadParticleDraw";
+    defines_ = "#define INSTANCED_QUADS\n";
+    loadShaderSource(GL_VERTEX_SHADER, "./shaders/particlesDraw.vs.glsl");
+    loadShaderSource(GL_FRAGMENT_SHADER, "./shaders/particlesDraw.fs.glsl");
+    link();
+}
+
+void SoftParticleDrawShader::load() {
+    name_ = "SoftParticleDraw";
+    defines_ = "#define WEIGHTED_OIT\n#define SOFT_PARTICLES\n";
+    loadShaderSource(GL_VERTEX_SHADER, "./shaders/particlesDraw.vs.glsl");
+    loadShaderSource(GL_GEOMETRY_SHADER, "./shaders/particlesDraw.gs.glsl");
+    loadShaderSource(GL_FRAGMENT_SHADER, "./shaders/particlesDraw.fs.glsl");
+    link();
+}
+
+void SoftQuadParticleDrawShader::load() {
+    name_ = "SoftQuadParticleDraw";
+    defines_ = "#define WEIGHTED_OIT\n#define SOFT_PARTICLES\n#define INSTANCED_QUADS\n";
+    loadShaderSource(GL_VERTEX_SHADER, "./shaders/particlesDraw.vs.glsl");
+    loadShaderSource(GL_FRAGMENT_SHADER, "./shaders/particlesDraw.fs.glsl");
+    link();
+}
+
+void ParticleDepthDownsample::load() {
+    name_ = "ParticleDepthDownsample";
+    loadShaderSource(GL_VERTEX_SHADER, "./shaders/fullscreen.vs.glsl");
+    loadShaderSource(GL_FRAGMENT_SHADER, "./shaders/particleDepthDownsample.fs.glsl");
+    link();
+}
+
+void ParticleDepthDownsample::getAllUniformLocations() {
+    downscaleULoc = glGetUniformLocation(id_, "downscale");
+    depthParamsULoc = glGetUniformLocation(id_, "depthParams");
+}
+
+void SoftParticleComposite::load() {
+    name_ = "SoftParticleComposite";
+    loadShaderSource(GL_VERTEX_SHADER, "./shaders/fullscreen.vs.glsl");
+    loadShaderSource(GL_FRAGMENT_SHADER, "./shaders/softParticleComposite.fs.glsl");
+    link();
+}
+
+void SoftParticleComposite::getAllUniformLocations() {
+    downscaleULoc = glGetUniformLocation(id_, "downscale");
+    depthParamsULoc = glGetUniformLocation(id_, "depthParams");
 }
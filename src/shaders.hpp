@@ -1,12 +1,16 @@
+#ifndef SHADERS_H
+#define SHADERS_H
+
 #include "shader_program.hpp"
 
 #include <glm/glm.hpp>
 
-class EdgeEffect : public ShaderProgram
+class OutlineShader : public ShaderProgram
 {
 public:
-    GLuint mvpULoc;
-    GLuint colorULoc;
+    GLuint thicknessULoc;
+    GLuint depthEdgeThresholdULoc;
+    GLuint depthParamsULoc;
 
 protected:
     virtual void load() override;
@@ -25,20 +29,22 @@ protected:
 };
 
 
+// La matrice modèle de chaque objet est lue dans InstanceBlock; seules les
+// matrices de la caméra sont des uniformes, fixées une fois par image.
 class CelShading : public ShaderProgram
 {
 public:
-    GLuint mvpULoc;
+    GLuint projViewULoc;
     GLuint viewULoc;
-    GLuint modelViewULoc;
-    GLuint normalULoc;
-    
-    GLuint nSpotLightsULoc;
     
     GLuint globalAmbientULoc;
+    
+    GLuint clusterGridSizeULoc;
+    GLuint clusterTileSizeULoc;
+    GLuint clusterDepthParamsULoc;
 
 public:
-    void setMatrices(const glm::mat4& mvp, const glm::mat4& view, const glm::mat4& model);
+    void setViewMatrices(const glm::mat4& projView, const glm::mat4& view);
 
 protected:
     virtual void load() override;
@@ -46,6 +52,82 @@ protected:
     virtual void assignAllUniformBlockIndexes() override;
 };
 
+// Même éclairage que CelShading, mais le matériau de chaque instance est lu
+// dans MaterialTableBlock plutôt que dans MaterialBlock.
+class InstancedCelShading : public CelShading
+{
+protected:
+    virtual void load() override;
+    virtual void assignAllUniformBlockIndexes() override;
+};
+
+// Même éclairage que CelShading, écrit dans les cibles de TransparencyPass.
+class TransparentCelShading : public CelShading
+{
+protected:
+    virtual void load() override;
+};
+
+class TransparencyComposite : public ShaderProgram
+{
+protected:
+    virtual void load() override;
+    virtual void getAllUniformLocations() override;
+};
+
+// Passe de profondeur seulement des cartes d'ombres: même géométrie et même
+// InstanceBlock que les autres passes, sans nuanceur de fragments.
+class ShadowDepth : public ShaderProgram
+{
+public:
+    GLuint lightProjViewULoc;
+
+protected:
+    virtual void load() override;
+    virtual void getAllUniformLocations() override;
+};
+
+class LightClusterShader : public ShaderProgram
+{
+public:
+    GLuint viewULoc;
+    GLuint nSpotLightsULoc;
+    GLuint clusterGridSizeULoc;
+    GLuint projScaleULoc;
+    GLuint zNearULoc;
+    GLuint zFarULoc;
+
+protected:
+    virtual void load() override;
+    virtual void getAllUniformLocations() override;
+};
+
+class DepthPyramidShader : public ShaderProgram
+{
+public:
+    GLuint sourceLevelULoc;
+
+protected:
+    virtual void load() override;
+    virtual void getAllUniformLocations() override;
+};
+
+class OcclusionCullShader : public ShaderProgram
+{
+public:
+    GLuint nObjectsULoc;
+    GLuint frustumPlanesULoc;
+    GLuint isLatePassULoc;
+    GLuint viewULoc;
+    GLuint projectionULoc;
+    GLuint zNearULoc;
+    GLuint pyramidSizeULoc;
+
+protected:
+    virtual void load() override;
+    virtual void getAllUniformLocations() override;
+};
+
 class GrassShader : public ShaderProgram
 {
 public:
@@ -57,27 +139,144 @@ protected:
     virtual void getAllUniformLocations() override;
 };
 
-class ParticleComputeShader : public ShaderProgram
+class ParticleEmitShader : public ShaderProgram
 {
 public:
     GLuint timeULoc;
+    GLuint nEmittedULoc;
+    GLuint nEmittersULoc;
+
+protected:
+    virtual void load() override;
+    virtual void getAllUniformLocations() override;
+};
+
+// Remplace les particules mortes après la simulation, pour ParticleSystem::setFixedCount.
+class ParticleRefillShader : public ParticleEmitShader
+{
+protected:
+    virtual void load() override;
+};
+
+class ParticleSimulateShader : public ShaderProgram
+{
+public:
     GLuint deltaTimeULoc;
-    GLuint emitterPositionULoc;
-    GLuint emitterDirectionULoc;
 
 protected:
     virtual void load() override;
     virtual void getAllUniformLocations() override;
 };
 
+class ParticleArgumentsShader : public ShaderProgram
+{
+public:
+    GLuint stageULoc;
+    GLuint fixedCountULoc;
+
+protected:
+    virtual void load() override;
+    virtual void getAllUniformLocations() override;
+};
+
+class ParticleSortHistogramShader : public ShaderProgram
+{
+public:
+    GLuint shiftULoc;
+    GLuint computeKeysULoc;
+    GLuint viewULoc;
+    GLuint maxDepthULoc;
+
+protected:
+    virtual void load() override;
+    virtual void getAllUniformLocations() override;
+};
+
+class ParticleSortScanShader : public ShaderProgram
+{
+protected:
+    virtual void load() override;
+    virtual void getAllUniformLocations() override;
+};
+
+class ParticleSortScatterShader : public ShaderProgram
+{
+public:
+    GLuint shiftULoc;
+
+protected:
+    virtual void load() override;
+    virtual void getAllUniformLocations() override;
+};
+
+// Écrit dans les cibles de TransparencyPass.
 class ParticleDrawShader : public ShaderProgram
 {
 public:
     GLuint projectionULoc;
     GLuint modelViewULoc;
     GLuint textureSamplerULoc;
+    GLuint depthParamsULoc;
+    GLuint softnessULoc;
 
 protected:
     virtual void load() override;
     virtual void getAllUniformLocations() override;
 };
+
+// Fusion alpha ordinaire, pour des particules déjà triées de l'arrière vers l'avant.
+class SortedParticleDrawShader : public ParticleDrawShader
+{
+protected:
+    virtual void load() override;
+};
+
+// Variantes sans nuanceur de géométrie, pour ParticleSystem::INSTANCED_QUADS.
+class QuadParticleDrawShader : public ParticleDrawShader
+{
+protected:
+    virtual void load() override;
+};
+
+class SortedQuadParticleDrawShader : public ParticleDrawShader
+{
+protected:
+    virtual void load() override;
+};
+
+// Variantes pour SoftParticlePass, avec fondu près des surfaces opaques.
+class SoftParticleDrawShader : public ParticleDrawShader
+{
+protected:
+    virtual void load() override;
+};
+
+class SoftQuadParticleDrawShader : public ParticleDrawShader
+{
+protected:
+    virtual void load() override;
+};
+
+class ParticleDepthDownsample : public ShaderProgram
+{
+public:
+    GLuint downscaleULoc;
+    GLuint depthParamsULoc;
+
+protected:
+    virtual void load() override;
+    virtual void getAllUniformLocations() override;
+};
+
+class SoftParticleComposite : public ShaderProgram
+{
+public:
+    GLuint downscaleULoc;
+    GLuint depthParamsULoc;
+
+protected:
+    virtual void load() override;
+    virtual void getAllUniformLocations() override;
+};
+
+#endif // SHADERS_H
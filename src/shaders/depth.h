@@ -0,0 +1,25 @@
+#ifndef DEPTH_H
+#define DEPTH_H
+
+// Profondeur [0, 1] -> distance à la caméra, commune aux passes et aux
+// nuanceurs (#include "depth.h"). Côté C++, glm doit déjà être inclus.
+
+#ifdef __cplusplus
+
+inline glm::vec2 getDepthParams(const glm::mat4& projection)
+{
+    return glm::vec2(projection[2][2], projection[3][2]);
+}
+
+#else
+
+uniform vec2 depthParams;
+
+float linearDepth(float depth)
+{
+    return depthParams.y / (depth * 2.0 - 1.0 + depthParams.x);
+}
+
+#endif // __cplusplus
+
+#endif // DEPTH_H
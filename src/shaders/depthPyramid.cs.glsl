@@ -0,0 +1,30 @@
+#version 430 core
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+// Profondeur de l'écran pour le niveau 0, niveau précédent de la pyramide ensuite.
+layout(binding = 3) uniform sampler2D source;
+layout(r32f, binding = 0) writeonly uniform image2D destination;
+
+uniform int sourceLevel;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 destinationSize = imageSize(destination);
+    if (any(greaterThanEqual(texel, destinationSize)))
+        return;
+
+    // Texels source couverts par ce texel, bornes arrondies vers l'extérieur
+    // pour qu'aucun ne soit oublié quand les tailles ne sont pas divisibles.
+    ivec2 sourceSize = textureSize(source, sourceLevel);
+    ivec2 begin = texel * sourceSize / destinationSize;
+    ivec2 end = min(((texel + 1) * sourceSize + destinationSize - 1) / destinationSize, sourceSize);
+
+    float maxDepth = 0.0;
+    for (int y = begin.y; y < end.y; y++)
+        for (int x = begin.x; x < end.x; x++)
+            maxDepth = max(maxDepth, texelFetch(source, ivec2(x, y), sourceLevel).r);
+
+    imageStore(destination, texel, vec4(maxDepth));
+}
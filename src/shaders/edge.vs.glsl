@@ -1,11 +0,0 @@
-#version 330 core
-
-layout (location = 0) in vec3 position;
-layout (location = 2) in vec3 normal;
-
-uniform mat4 mvp;
-
-void main()
-{
-    gl_Position = mvp * vec4(position + normal * 0.05, 1.0);
-}
@@ -0,0 +1,11 @@
+#version 430 core
+
+out vec2 texCoords;
+
+// Triangle qui couvre tout l'écran, sans tampon de sommets.
+void main()
+{
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    texCoords = position;
+    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,82 @@
+#version 430 core
+
+#define MAX_LIGHTS_PER_CLUSTER 32
+
+// Portée des lumières: l'atténuation de phong.fs est nulle au-delà.
+#define LIGHT_RADIUS 10.0
+
+layout(local_size_x = 64) in;
+
+struct SpotLight
+{
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+
+    vec3 position;
+    vec3 direction;
+    float exponent;
+    float openingAngle;
+    int shadowMapIndex;
+};
+
+layout (std430, binding = 5) readonly buffer SpotLightBlock
+{
+    SpotLight spotLights[];
+};
+
+layout (std430, binding = 4) writeonly restrict buffer LightClusterBlock
+{
+    uint clusterLights[];
+};
+
+uniform mat4 view;
+uniform int nSpotLights;
+
+uniform uvec3 clusterGridSize;
+// projection[0][0] et projection[1][1]: NDC -> vue pour une profondeur donnée
+uniform vec2 projScale;
+uniform float zNear;
+uniform float zFar;
+
+void main()
+{
+    uint clusterIndex = gl_GlobalInvocationID.x;
+    uint nClusters = clusterGridSize.x * clusterGridSize.y * clusterGridSize.z;
+    if (clusterIndex >= nClusters)
+        return;
+
+    uvec3 cluster = uvec3(clusterIndex % clusterGridSize.x,
+                          (clusterIndex / clusterGridSize.x) % clusterGridSize.y,
+                          clusterIndex / (clusterGridSize.x * clusterGridSize.y));
+
+    // Boîte englobante de la grappe en espace de vue, tranches exponentielles en profondeur.
+    vec2 ndcMin = vec2(cluster.xy) / vec2(clusterGridSize.xy) * 2.0 - 1.0;
+    vec2 ndcMax = vec2(cluster.xy + 1u) / vec2(clusterGridSize.xy) * 2.0 - 1.0;
+    float depths[2] = float[2](zNear * pow(zFar / zNear, float(cluster.z) / float(clusterGridSize.z)),
+                               zNear * pow(zFar / zNear, float(cluster.z + 1u) / float(clusterGridSize.z)));
+
+    vec3 aabbMin = vec3(1e30);
+    vec3 aabbMax = vec3(-1e30);
+    for (int i = 0; i < 2; i++)
+    {
+        vec2 xyMin = ndcMin / projScale * depths[i];
+        vec2 xyMax = ndcMax / projScale * depths[i];
+        aabbMin = min(aabbMin, vec3(min(xyMin, xyMax), -depths[i]));
+        aabbMax = max(aabbMax, vec3(max(xyMin, xyMax), -depths[i]));
+    }
+
+    uint offset = clusterIndex * (MAX_LIGHTS_PER_CLUSTER + 1);
+    uint count = 0u;
+    for (int i = 0; i < nSpotLights && count < MAX_LIGHTS_PER_CLUSTER; i++)
+    {
+        vec3 center = (view * vec4(spotLights[i].position, 1.0)).xyz;
+        vec3 delta = center - clamp(center, aabbMin, aabbMax);
+        if (dot(delta, delta) <= LIGHT_RADIUS * LIGHT_RADIUS)
+        {
+            clusterLights[offset + 1u + count] = uint(i);
+            count++;
+        }
+    }
+    clusterLights[offset] = count;
+}
@@ -0,0 +1,124 @@
+#version 430 core
+
+layout(local_size_x = 64) in;
+
+struct DrawCommand
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+struct CullObject
+{
+    vec4 sphere;
+    DrawCommand command;
+    uint isVisible;
+};
+
+layout (std430, binding = 6) restrict buffer CullObjectBlock
+{
+    CullObject objects[];
+};
+
+// Phase précoce puis phase tardive, nObjects commandes chacune.
+layout (std430, binding = 7) writeonly restrict buffer DrawCommandBlock
+{
+    DrawCommand commands[];
+};
+
+layout(binding = 3) uniform sampler2D depthPyramid;
+
+uniform uint nObjects;
+uniform vec4 frustumPlanes[6];
+uniform bool isLatePass;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float zNear;
+uniform vec2 pyramidSize;
+
+bool isInFrustum(vec4 sphere)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        if (dot(frustumPlanes[i].xyz, sphere.xyz) + frustumPlanes[i].w < -sphere.w)
+            return false;
+    }
+    return true;
+}
+
+// Rectangle écran (coordonnées de texture) de la sphère, d'après Mara et
+// McGuire, "2D Polyhedral Bounds of a Clipped, Perspective-Projected 3D Sphere".
+// center est en espace de vue avec z positif devant la caméra.
+bool projectSphere(vec3 center, float radius, out vec4 rect)
+{
+    if (center.z < radius + zNear)
+        return false;
+
+    vec3 cr = center * radius;
+    float czr2 = center.z * center.z - radius * radius;
+
+    float vx = sqrt(center.x * center.x + czr2);
+    float minX = (vx * center.x - cr.z) / (vx * center.z + cr.x);
+    float maxX = (vx * center.x + cr.z) / (vx * center.z - cr.x);
+
+    float vy = sqrt(center.y * center.y + czr2);
+    float minY = (vy * center.y - cr.z) / (vy * center.z + cr.y);
+    float maxY = (vy * center.y + cr.z) / (vy * center.z - cr.y);
+
+    rect = vec4(minX * projection[0][0], minY * projection[1][1],
+                maxX * projection[0][0], maxY * projection[1][1]) * 0.5 + 0.5;
+    return true;
+}
+
+bool isOccluded(vec4 sphere)
+{
+    vec3 center = (view * vec4(sphere.xyz, 1.0)).xyz;
+
+    // Une sphère qui traverse le plan proche couvre l'écran: on la garde.
+    vec4 rect;
+    if (!projectSphere(vec3(center.xy, -center.z), sphere.w, rect))
+        return false;
+    rect = clamp(rect, 0.0, 1.0);
+
+    // Au niveau choisi, le rectangle touche au plus 2x2 texels: ses coins suffisent.
+    vec2 size = (rect.zw - rect.xy) * pyramidSize;
+    float level = ceil(log2(max(max(size.x, size.y), 1.0)));
+    float occluderDepth = max(max(textureLod(depthPyramid, rect.xy, level).r,
+                                  textureLod(depthPyramid, rect.zy, level).r),
+                              max(textureLod(depthPyramid, rect.xw, level).r,
+                                  textureLod(depthPyramid, rect.zw, level).r));
+
+    // Profondeur du point de la sphère le plus proche de la caméra.
+    vec4 nearestPoint = projection * vec4(0.0, 0.0, center.z + sphere.w, 1.0);
+    float sphereDepth = nearestPoint.z / nearestPoint.w * 0.5 + 0.5;
+    return sphereDepth > occluderDepth;
+}
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= nObjects)
+        return;
+
+    CullObject object = objects[i];
+    bool isInView = isInFrustum(object.sphere);
+    bool isDrawnEarly = isInView && object.isVisible != 0u;
+
+    DrawCommand command = object.command;
+    if (!isLatePass)
+    {
+        command.instanceCount = isDrawnEarly ? 1u : 0u;
+        commands[i] = command;
+        return;
+    }
+
+    bool isVisible = isInView && !isOccluded(object.sphere);
+    objects[i].isVisible = isVisible ? 1u : 0u;
+
+    command.instanceCount = isVisible && !isDrawnEarly ? 1u : 0u;
+    commands[nObjects + i] = command;
+}
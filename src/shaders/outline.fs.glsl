@@ -0,0 +1,60 @@
+#version 430 core
+
+#include "depth.h"
+
+#define MAX_THICKNESS 8
+
+in vec2 texCoords;
+
+out vec4 FragColor;
+
+layout(binding = 4) uniform sampler2D sceneColor;
+layout(binding = 5) uniform sampler2D sceneDepth;
+layout(binding = 6) uniform usampler2D objectIds;
+
+uniform int thickness;
+uniform float depthEdgeThreshold;
+
+const vec3 OUTLINE_COLOR = vec3(0.0);
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    ivec2 size = textureSize(sceneDepth, 0);
+
+    float depth = texelFetch(sceneDepth, texel, 0).r;
+    float distance = linearDepth(depth);
+    uint id = texelFetch(objectIds, texel, 0).r;
+
+    // Un voisin d'un objet à contour, devant ce pixel, l'assombrit si son
+    // identifiant diffère (silhouette) ou si sa profondeur saute (bord intérieur).
+    // Seul le disque de rayon thickness est parcouru, rangée par rangée: le
+    // coût suit l'épaisseur choisie.
+    bool isOutline = false;
+    int radius = clamp(thickness, 0, MAX_THICKNESS);
+    for (int y = -radius; y <= radius && !isOutline; y++)
+    {
+        int halfWidth = int(sqrt(float(radius * radius - y * y)) + 0.01);
+        for (int x = -halfWidth; x <= halfWidth; x++)
+        {
+            ivec2 neighbor = clamp(texel + ivec2(x, y), ivec2(0), size - 1);
+            uint neighborId = texelFetch(objectIds, neighbor, 0).r;
+            if (neighborId == 0u)
+                continue;
+
+            float neighborDistance = linearDepth(texelFetch(sceneDepth, neighbor, 0).r);
+            if (neighborDistance >= distance)
+                continue;
+
+            if (neighborId != id || distance - neighborDistance > depthEdgeThreshold * distance)
+            {
+                isOutline = true;
+                break;
+            }
+        }
+    }
+
+    vec3 color = texelFetch(sceneColor, texel, 0).rgb;
+    FragColor = vec4(isOutline ? OUTLINE_COLOR : color, 1.0);
+    gl_FragDepth = depth;
+}
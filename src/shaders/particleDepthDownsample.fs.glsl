@@ -0,0 +1,26 @@
+#version 430 core
+
+#include "depth.h"
+
+out float sceneDistance;
+
+layout(binding = 7) uniform sampler2D sceneDepth;
+
+uniform int downscale;
+
+void main()
+{
+    // La surface la plus proche du bloc cache les particules derrière elle.
+    ivec2 sceneSize = textureSize(sceneDepth, 0);
+    ivec2 origin = ivec2(gl_FragCoord.xy) * downscale;
+    float depth = 1.0;
+    for (int y = 0; y < downscale; y++)
+    {
+        for (int x = 0; x < downscale; x++)
+        {
+            ivec2 texel = min(origin + ivec2(x, y), sceneSize - 1);
+            depth = min(depth, texelFetch(sceneDepth, texel, 0).r);
+        }
+    }
+    sceneDistance = linearDepth(depth);
+}
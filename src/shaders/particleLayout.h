@@ -0,0 +1,200 @@
+#ifndef PARTICLE_LAYOUT_H
+#define PARTICLE_LAYOUT_H
+
+// Disposition des particules, commune à particle_system.cpp et aux nuanceurs
+// de particules (#include "particleLayout.h"). Côté C++, glm et les types GL
+// doivent déjà être inclus.
+
+#define PARTICLE_WORKGROUP_SIZE 64
+
+// Blocs de stockage
+#define PARTICLE_POSITION_BINDING 8
+#define PARTICLE_MOTION_BINDING 9
+#define PARTICLE_LIFE_BINDING 10
+#define PARTICLE_DEAD_LIST_BINDING 11
+#define PARTICLE_ALIVE_LIST_BINDING 12
+#define PARTICLE_SURVIVOR_LIST_BINDING 13
+#define PARTICLE_COUNTER_BINDING 14
+#define PARTICLE_EMITTER_BINDING 15
+#define PARTICLE_SORT_KEYS_IN_BINDING 16
+#define PARTICLE_SORT_KEYS_OUT_BINDING 17
+#define PARTICLE_SORT_VALUES_IN_BINDING 18
+#define PARTICLE_SORT_VALUES_OUT_BINDING 19
+#define PARTICLE_SORT_HISTOGRAM_BINDING 20
+
+// Un tableau par champ, 24 octets par particule:
+// - position: 3 float, les demi-flottants manquant de précision à l'échelle de la scène;
+// - motion: 2 uint de demi-flottants, (vitesse.x, vitesse.y) et (vitesse.z, orientation initiale);
+// - life: 1 uint de demi-flottants, (temps restant, durée de vie).
+// La couleur, la taille et l'orientation courante se déduisent de l'âge.
+#define PARTICLE_POSITION_FLOATS 3
+#define PARTICLE_MOTION_UINTS 2
+#define PARTICLE_LIFE_UINTS 1
+
+// Tri par base des survivantes selon la profondeur: clés de 16 bits, deux
+// passes de 8 bits. Chaque groupe traite une tuile de PARTICLE_SORT_TILE_SIZE
+// indices; PARTICLE_SORT_WORKGROUP_SIZE doit valoir PARTICLE_SORT_BINS.
+#define PARTICLE_SORT_KEY_BITS 16
+#define PARTICLE_SORT_RADIX_BITS 8
+#define PARTICLE_SORT_BINS 256
+#define PARTICLE_SORT_WORKGROUP_SIZE 256
+#define PARTICLE_SORT_ITEMS_PER_THREAD 4
+#define PARTICLE_SORT_TILE_SIZE (PARTICLE_SORT_WORKGROUP_SIZE * PARTICLE_SORT_ITEMS_PER_THREAD)
+#define PARTICLE_SORT_SCAN_WORKGROUP_SIZE 1024
+
+// ParticleCounterBlock; simulateGroups, draw*, sortGroups, quad* et
+// refillGroups sont lus par les commandes indirectes. refillCount est le nombre
+// de particules à ajouter aux survivantes pour un nombre fixe de particules.
+#define PARTICLE_COUNTER_FIELDS \
+    uint nDead; \
+    uint nAlive; \
+    uint nSurvivors; \
+    uint padding; \
+    uint simulateGroups[3]; \
+    uint drawCount; \
+    uint drawInstanceCount; \
+    uint drawFirst; \
+    uint drawBaseInstance; \
+    uint sortGroups[3]; \
+    uint quadCount; \
+    uint quadInstanceCount; \
+    uint quadFirst; \
+    uint quadBaseInstance; \
+    uint refillCount; \
+    uint refillGroups[3];
+
+// Chaque émetteur reçoit les fils [firstParticle, firstParticle + nParticles) de l'émission.
+#define PARTICLE_EMITTER_FIELDS \
+    vec4 position; \
+    vec4 direction; \
+    uint firstParticle; \
+    uint nParticles; \
+    uint padding[2];
+
+#ifdef __cplusplus
+
+namespace particle_layout
+{
+    using uint = gl::GLuint;
+    using vec4 = glm::vec4;
+
+    struct Counters { PARTICLE_COUNTER_FIELDS };
+    struct Emitter { PARTICLE_EMITTER_FIELDS };
+}
+
+#else
+
+struct Emitter { PARTICLE_EMITTER_FIELDS };
+
+layout(std430, binding = PARTICLE_POSITION_BINDING) restrict buffer ParticlePositionBlock
+{
+    float positions[];
+};
+
+layout(std430, binding = PARTICLE_MOTION_BINDING) restrict buffer ParticleMotionBlock
+{
+    uvec2 motions[];
+};
+
+layout(std430, binding = PARTICLE_LIFE_BINDING) restrict buffer ParticleLifeBlock
+{
+    uint lives[];
+};
+
+layout(std430, binding = PARTICLE_DEAD_LIST_BINDING) restrict buffer DeadListBlock
+{
+    uint deadList[];
+};
+
+layout(std430, binding = PARTICLE_ALIVE_LIST_BINDING) restrict buffer AliveListBlock
+{
+    uint aliveList[];
+};
+
+layout(std430, binding = PARTICLE_SURVIVOR_LIST_BINDING) restrict buffer SurvivorListBlock
+{
+    uint survivors[];
+};
+
+layout(std430, binding = PARTICLE_COUNTER_BINDING) restrict buffer ParticleCounterBlock
+{
+    PARTICLE_COUNTER_FIELDS
+};
+
+layout(std430, binding = PARTICLE_EMITTER_BINDING) readonly restrict buffer EmitterBlock
+{
+    Emitter emitters[];
+};
+
+layout(std430, binding = PARTICLE_SORT_KEYS_IN_BINDING) restrict buffer SortKeysInBlock
+{
+    uint sortKeysIn[];
+};
+
+layout(std430, binding = PARTICLE_SORT_KEYS_OUT_BINDING) writeonly restrict buffer SortKeysOutBlock
+{
+    uint sortKeysOut[];
+};
+
+layout(std430, binding = PARTICLE_SORT_VALUES_IN_BINDING) readonly restrict buffer SortValuesInBlock
+{
+    uint sortValuesIn[];
+};
+
+layout(std430, binding = PARTICLE_SORT_VALUES_OUT_BINDING) writeonly restrict buffer SortValuesOutBlock
+{
+    uint sortValuesOut[];
+};
+
+// Compte de chaque chiffre par tuile, rangé chiffre par chiffre: après la
+// somme préfixe, chaque entrée est la position de départ de sa tuile.
+layout(std430, binding = PARTICLE_SORT_HISTOGRAM_BINDING) restrict buffer SortHistogramBlock
+{
+    uint sortHistogram[];
+};
+
+vec3 loadParticlePosition(uint index)
+{
+    uint i = index * PARTICLE_POSITION_FLOATS;
+    return vec3(positions[i], positions[i + 1u], positions[i + 2u]);
+}
+
+void storeParticlePosition(uint index, vec3 position)
+{
+    uint i = index * PARTICLE_POSITION_FLOATS;
+    positions[i] = position.x;
+    positions[i + 1u] = position.y;
+    positions[i + 2u] = position.z;
+}
+
+vec3 unpackParticleVelocity(uvec2 motion)
+{
+    return vec3(unpackHalf2x16(motion.x), unpackHalf2x16(motion.y).x);
+}
+
+float unpackParticleOrientation(uvec2 motion)
+{
+    return unpackHalf2x16(motion.y).y;
+}
+
+uvec2 packParticleMotion(vec3 velocity, float orientation)
+{
+    return uvec2(packHalf2x16(velocity.xy), packHalf2x16(vec2(velocity.z, orientation)));
+}
+
+// Apparence selon la fraction de vie restante.
+vec4 particleColor(float lifeRatio)
+{
+    vec3 rgbColor = mix(vec3(1.0), vec3(0.5), lifeRatio);
+    float fade = smoothstep(0.0, 0.2, lifeRatio) * (1.0 - smoothstep(0.8, 1.0, lifeRatio));
+    return vec4(rgbColor, 0.2 * fade);
+}
+
+float particleSize(float lifeRatio)
+{
+    return mix(0.5, 0.2, lifeRatio);
+}
+
+#endif // __cplusplus
+
+#endif // PARTICLE_LAYOUT_H
@@ -0,0 +1,41 @@
+#version 430 core
+
+#include "particleLayout.h"
+
+// Un seul fil: recopie les compteurs dans les arguments des commandes indirectes.
+layout(local_size_x = 1) in;
+
+#define STAGE_SIMULATE 0
+#define STAGE_DRAW 1
+#define STAGE_REFILL 2
+
+uniform int stage;
+// Nombre de particules à garder, pour l'étape refill.
+uniform uint fixedCount;
+
+void main()
+{
+    if (stage == STAGE_SIMULATE)
+    {
+        simulateGroups[0] = (nAlive + PARTICLE_WORKGROUP_SIZE - 1u) / PARTICLE_WORKGROUP_SIZE;
+        nSurvivors = 0u;
+    }
+    else if (stage == STAGE_REFILL)
+    {
+        refillCount = fixedCount > nSurvivors ? fixedCount - nSurvivors : 0u;
+        refillGroups[0] = (refillCount + PARTICLE_WORKGROUP_SIZE - 1u) / PARTICLE_WORKGROUP_SIZE;
+    }
+    else
+    {
+        // Les particules ajoutées par le remplissage sont des survivantes.
+        nSurvivors += refillCount;
+        nDead -= refillCount;
+        refillCount = 0u;
+
+        // Les survivantes sont la liste vivante de l'image suivante.
+        drawCount = nSurvivors;
+        quadInstanceCount = nSurvivors;
+        nAlive = nSurvivors;
+        sortGroups[0] = (nSurvivors + PARTICLE_SORT_TILE_SIZE - 1u) / PARTICLE_SORT_TILE_SIZE;
+    }
+}
@@ -1,4 +1,8 @@
-#version 330 core
+#version 430 core
+
+#ifdef SOFT_PARTICLES
+#include "depth.h"
+#endif
 
 in ATTRIB_GS_OUT
 {
@@ -6,13 +10,42 @@ in ATTRIB_GS_OUT
     vec2 uv;
 } attribIn;
 
+#ifdef WEIGHTED_OIT
+// Cibles de TransparencyPass
+layout(location = 0) out vec4 accumulation;
+layout(location = 1) out float revealage;
+#else
 out vec4 FragColor;
+#endif
 
 uniform sampler2D textureSampler;
 
+#ifdef SOFT_PARTICLES
+// Distance de la scène à la résolution de SoftParticlePass.
+layout(binding = 6) uniform sampler2D sceneDistance;
+// Distance sur laquelle une particule s'estompe devant une surface.
+uniform float softness;
+#endif
+
 void main()
 {
     vec4 texColor = texture(textureSampler, attribIn.uv);
     if (texColor.a < 0.02) discard;
-    FragColor = texColor * attribIn.color;
+    vec4 color = texColor * attribIn.color;
+
+#ifdef SOFT_PARTICLES
+    float distance = linearDepth(gl_FragCoord.z);
+    float fade = clamp((texelFetch(sceneDistance, ivec2(gl_FragCoord.xy), 0).r - distance) / softness, 0.0, 1.0);
+    if (fade <= 0.0) discard;
+    color.a *= fade;
+#endif
+
+#ifdef WEIGHTED_OIT
+    // Mêmes poids que phong.fs avec WEIGHTED_OIT.
+    float weight = color.a * clamp(3e3 * pow(1.0 - gl_FragCoord.z, 3.0), 1e-2, 3e3);
+    accumulation = vec4(color.rgb * color.a, color.a) * weight;
+    revealage = color.a;
+#else
+    FragColor = color;
+#endif
 }
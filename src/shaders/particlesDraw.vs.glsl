@@ -1,24 +1,57 @@
-#version 330 core
+#version 430 core
 
-layout(location = 0) in vec3 aPos;
-layout(location = 1) in float aZOrientation;
-layout(location = 3) in vec4 aColor;
-layout(location = 4) in vec2 aSize;
+#include "particleLayout.h"
 
+#ifdef INSTANCED_QUADS
+// Une instance par particule; les 4 sommets du quadrilatère sont formés ici
+// plutôt que dans particlesDraw.gs, d'où le nom du bloc lu par particlesDraw.fs.
+out ATTRIB_GS_OUT
+{
+    vec4 color;
+    vec2 uv;
+} attribOut;
+
+uniform mat4 projection;
+#else
 out ATTRIB_VS_OUT
 {
     vec4 color;
     vec2 size;
     float zOrientation;
 } attribOut;
+#endif
 
 uniform mat4 modelView;
 
 void main()
 {
-    gl_Position = modelView * vec4(aPos, 1.0);
+#ifdef INSTANCED_QUADS
+    uint index = survivors[gl_InstanceID];
+#else
+    uint index = survivors[gl_VertexID];
+#endif
+    vec2 life = unpackHalf2x16(lives[index]);
+    float lifeRatio = life.x / life.y;
+    float age = life.y - life.x;
+
+    vec4 centerPos = modelView * vec4(loadParticlePosition(index), 1.0);
+    float zOrientation = unpackParticleOrientation(motions[index]) + 0.5 * age;
+
+#ifdef INSTANCED_QUADS
+    // Même ordre de sommets que la bande de particlesDraw.gs.
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    float c = cos(zOrientation);
+    float s = sin(zOrientation);
+    vec2 offset = mat2(c, s, -s, c) * ((corner - 0.5) * particleSize(lifeRatio));
+
+    gl_Position = projection * (centerPos + vec4(offset, 0.0, 0.0));
+    attribOut.color = particleColor(lifeRatio);
+    attribOut.uv = corner;
+#else
+    gl_Position = centerPos;
     
-    attribOut.color = aColor;
-    attribOut.size = aSize;
-    attribOut.zOrientation = aZOrientation;
+    attribOut.color = particleColor(lifeRatio);
+    attribOut.size = vec2(particleSize(lifeRatio));
+    attribOut.zOrientation = zOrientation;
+#endif
 }
@@ -0,0 +1,62 @@
+#version 430 core
+
+#include "particleLayout.h"
+
+layout(local_size_x = PARTICLE_WORKGROUP_SIZE) in;
+
+uniform float time;
+uniform uint nEmitted;
+uniform uint nEmitters;
+
+float rand01(float seed)
+{
+    return fract(sin(dot(vec2(time * 100.0 + seed, gl_GlobalInvocationID.x), vec2(12.9898, 78.233))) * 43758.5453);
+}
+
+void spawnParticle(uint index, uint e)
+{
+    vec3 velocity = (emitters[e].direction.xyz * 0.3) + vec3(0.0, 0.2, 0.0);
+    float orientation = rand01(0.0) * 6.28318530718;
+    float maxTimeToLive = 1.5 + (rand01(1.0) * 0.5);
+
+    storeParticlePosition(index, emitters[e].position.xyz);
+    motions[index] = packParticleMotion(velocity, orientation);
+    lives[index] = packHalf2x16(vec2(maxTimeToLive, maxTimeToLive));
+}
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+
+#ifdef REFILL
+    // Après la simulation: remplace les mortes pour garder un nombre fixe de
+    // particules. Le compte est connu d'avance, les indices libres et les places
+    // sont donc pris en bloc; l'étape de dessin de particlesArguments.cs met les
+    // compteurs à jour.
+    if (i >= refillCount)
+        return;
+
+    uint e = i % nEmitters;
+    uint index = deadList[nDead - 1u - i];
+    survivors[nSurvivors + i] = index;
+#else
+    if (i >= nEmitted)
+        return;
+
+    uint e = 0u;
+    while (e + 1u < nEmitters && i >= emitters[e].firstParticle + emitters[e].nParticles)
+        e++;
+
+    // Prend un indice libre; si la liste est vide, le décompte est rétabli.
+    int deadSlot = int(atomicAdd(nDead, 0xFFFFFFFFu)) - 1;
+    if (deadSlot < 0)
+    {
+        atomicAdd(nDead, 1u);
+        return;
+    }
+    uint index = deadList[deadSlot];
+    aliveList[atomicAdd(nAlive, 1u)] = index;
+#endif
+
+    spawnParticle(index, e);
+}
@@ -0,0 +1,31 @@
+#version 430 core
+
+#include "particleLayout.h"
+
+layout(local_size_x = PARTICLE_WORKGROUP_SIZE) in;
+
+uniform float deltaTime;
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= nAlive)
+        return;
+
+    uint index = aliveList[i];
+    vec2 life = unpackHalf2x16(lives[index]);
+
+    // Une particule morte rend son indice; les autres sont compactées dans survivors.
+    life.x -= deltaTime;
+    if (life.x <= 0.0)
+    {
+        deadList[atomicAdd(nDead, 1u)] = index;
+        return;
+    }
+
+    vec3 velocity = unpackParticleVelocity(motions[index]);
+    storeParticlePosition(index, loadParticlePosition(index) + velocity * deltaTime);
+    lives[index] = packHalf2x16(life);
+
+    survivors[atomicAdd(nSurvivors, 1u)] = index;
+}
@@ -0,0 +1,47 @@
+#version 430 core
+
+#include "particleLayout.h"
+
+layout(local_size_x = PARTICLE_SORT_WORKGROUP_SIZE) in;
+
+uniform uint shift;
+// Première passe: calcule aussi les clés à partir des positions.
+uniform bool computeKeys;
+uniform mat4 view;
+uniform float maxDepth;
+
+shared uint localHistogram[PARTICLE_SORT_BINS];
+
+void main()
+{
+    uint lid = gl_LocalInvocationID.x;
+    uint tile = gl_WorkGroupID.x;
+
+    localHistogram[lid] = 0u;
+    barrier();
+
+    uint tileStart = tile * PARTICLE_SORT_TILE_SIZE;
+    for (uint j = 0u; j < PARTICLE_SORT_ITEMS_PER_THREAD; j++)
+    {
+        uint i = tileStart + j * PARTICLE_SORT_WORKGROUP_SIZE + lid;
+        if (i >= nSurvivors)
+            break;
+
+        uint key;
+        if (computeKeys)
+        {
+            // Les plus éloignées ont les plus petites clés et sont dessinées d'abord.
+            float depth = -(view * vec4(loadParticlePosition(sortValuesIn[i]), 1.0)).z;
+            key = uint((1.0 - clamp(depth / maxDepth, 0.0, 1.0)) * float((1u << PARTICLE_SORT_KEY_BITS) - 1u));
+            sortKeysIn[i] = key;
+        }
+        else
+        {
+            key = sortKeysIn[i];
+        }
+        atomicAdd(localHistogram[(key >> shift) & (PARTICLE_SORT_BINS - 1u)], 1u);
+    }
+    barrier();
+
+    sortHistogram[lid * gl_NumWorkGroups.x + tile] = localHistogram[lid];
+}
@@ -0,0 +1,41 @@
+#version 430 core
+
+#include "particleLayout.h"
+
+// Un seul groupe: somme préfixe exclusive de tout l'histogramme. Chaque fil
+// additionne une tranche contiguë, puis les sommes des tranches sont balayées
+// en mémoire partagée.
+layout(local_size_x = PARTICLE_SORT_SCAN_WORKGROUP_SIZE) in;
+
+shared uint sliceSums[PARTICLE_SORT_SCAN_WORKGROUP_SIZE];
+
+void main()
+{
+    uint lid = gl_LocalInvocationID.x;
+    uint n = PARTICLE_SORT_BINS * sortGroups[0];
+    uint sliceSize = (n + PARTICLE_SORT_SCAN_WORKGROUP_SIZE - 1u) / PARTICLE_SORT_SCAN_WORKGROUP_SIZE;
+    uint sliceBegin = min(lid * sliceSize, n);
+    uint sliceEnd = min(sliceBegin + sliceSize, n);
+
+    uint sum = 0u;
+    for (uint i = sliceBegin; i < sliceEnd; i++)
+        sum += sortHistogram[i];
+    sliceSums[lid] = sum;
+    barrier();
+
+    for (uint offset = 1u; offset < PARTICLE_SORT_SCAN_WORKGROUP_SIZE; offset <<= 1u)
+    {
+        uint previous = lid >= offset ? sliceSums[lid - offset] : 0u;
+        barrier();
+        sliceSums[lid] += previous;
+        barrier();
+    }
+
+    uint prefix = sliceSums[lid] - sum;
+    for (uint i = sliceBegin; i < sliceEnd; i++)
+    {
+        uint count = sortHistogram[i];
+        sortHistogram[i] = prefix;
+        prefix += count;
+    }
+}
@@ -0,0 +1,62 @@
+#version 430 core
+
+#include "particleLayout.h"
+
+layout(local_size_x = PARTICLE_SORT_WORKGROUP_SIZE) in;
+
+#define MASK_WORDS (PARTICLE_SORT_WORKGROUP_SIZE / 32)
+
+uniform uint shift;
+
+// Un masque de bits par chiffre: le rang d'un fil parmi ceux qui ont le même
+// chiffre est le nombre de bits qui le précèdent, ce qui garde le tri stable.
+shared uint digitMasks[PARTICLE_SORT_BINS * MASK_WORDS];
+shared uint binOffsets[PARTICLE_SORT_BINS];
+
+void main()
+{
+    uint lid = gl_LocalInvocationID.x;
+    uint tile = gl_WorkGroupID.x;
+    uint word = lid / 32u;
+    uint bit = 1u << (lid % 32u);
+
+    binOffsets[lid] = sortHistogram[lid * gl_NumWorkGroups.x + tile];
+
+    uint tileStart = tile * PARTICLE_SORT_TILE_SIZE;
+    for (uint j = 0u; j < PARTICLE_SORT_ITEMS_PER_THREAD; j++)
+    {
+        for (uint w = 0u; w < MASK_WORDS; w++)
+            digitMasks[lid * MASK_WORDS + w] = 0u;
+        barrier();
+
+        uint i = tileStart + j * PARTICLE_SORT_WORKGROUP_SIZE + lid;
+        bool isValid = i < nSurvivors;
+        uint key = 0u;
+        uint digit = 0u;
+        if (isValid)
+        {
+            key = sortKeysIn[i];
+            digit = (key >> shift) & (PARTICLE_SORT_BINS - 1u);
+            atomicOr(digitMasks[digit * MASK_WORDS + word], bit);
+        }
+        barrier();
+
+        if (isValid)
+        {
+            uint rank = uint(bitCount(digitMasks[digit * MASK_WORDS + word] & (bit - 1u)));
+            for (uint w = 0u; w < word; w++)
+                rank += uint(bitCount(digitMasks[digit * MASK_WORDS + w]));
+
+            uint destination = binOffsets[digit] + rank;
+            sortKeysOut[destination] = key;
+            sortValuesOut[destination] = sortValuesIn[i];
+        }
+        barrier();
+
+        uint count = 0u;
+        for (uint w = 0u; w < MASK_WORDS; w++)
+            count += uint(bitCount(digitMasks[lid * MASK_WORDS + w]));
+        binOffsets[lid] += count;
+        barrier();
+    }
+}
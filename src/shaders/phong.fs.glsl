@@ -1,6 +1,11 @@
-#version 330 core
+#version 430 core
 
-#define MAX_SPOT_LIGHTS 12
+#define MAX_LIGHTS_PER_CLUSTER 32
+#define MAX_SHADOW_CASCADES 4
+#define MAX_SHADOWED_SPOTLIGHTS 4
+
+// Décalage le long de la normale contre l'acné d'ombre, en espace de vue.
+#define SHADOW_NORMAL_OFFSET 0.05
 
 in ATTRIBS_VS_OUT
 {
@@ -13,9 +18,6 @@ in LIGHTS_VS_OUT
 {
     vec3 obsPos;
     vec3 dirLightDir;
-    
-    vec3 spotLightsDir[MAX_SPOT_LIGHTS];
-    vec3 spotLightsSpotDir[MAX_SPOT_LIGHTS];
 } lightsIn;
 
 
@@ -26,6 +28,10 @@ struct Material
     vec3 diffuse;
     vec3 specular;
     float shininess;
+
+    int textureLayer;
+    bool isTextureClamped;
+    float textureLodBias;
 };
 
 struct DirectionalLight
@@ -47,26 +53,73 @@ struct SpotLight
     vec3 direction;
     float exponent;
     float openingAngle;
+    int shadowMapIndex;
 };
 
-uniform int nSpotLights;
+uniform mat4 view;
 
 uniform vec3 globalAmbient;
 
+// Lumières de chaque grappe (tuile de l'écran x tranche de profondeur), écrites
+// par lightClusters.cs: le nombre, suivi de MAX_LIGHTS_PER_CLUSTER indices.
+layout (std430, binding = 4) readonly buffer LightClusterBlock
+{
+    uint clusterLights[];
+};
+
+uniform uvec3 clusterGridSize;
+uniform vec2 clusterTileSize;
+// tranche = log(profondeur) * x - y
+uniform vec2 clusterDepthParams;
+
+#ifdef MATERIAL_TABLE
+flat in uint materialIndex;
+
+layout (std430, binding = 3) readonly buffer MaterialTableBlock
+{
+    Material materials[];
+};
+
+#define mat materials[materialIndex]
+#else
 layout (std140) uniform MaterialBlock
 {
     Material mat;
 };
+#endif
 
 layout (std140) uniform LightingBlock
 {
     DirectionalLight dirLight;
-    SpotLight spotLights[MAX_SPOT_LIGHTS];
 };
 
-uniform sampler2D diffuseSampler;
+// Projecteurs du LightManager, en nombre variable.
+layout (std430, binding = 5) readonly buffer SpotLightBlock
+{
+    SpotLight spotLights[];
+};
 
+// Matrices de l'espace de vue vers les coordonnées des cartes d'ombres.
+layout (std140) uniform ShadowBlock
+{
+    mat4 cascadeMatrices[MAX_SHADOW_CASCADES];
+    mat4 spotShadowMatrices[MAX_SHADOWED_SPOTLIGHTS];
+    // Profondeur de vue à la fin de chaque cascade
+    vec4 cascadeSplits;
+    int nCascades;
+};
+
+// Un tableau par taille de couche, aux unités MATERIAL_TEXTURE_UNIT et suivantes (material.hpp).
+layout (binding = 8) uniform sampler2DArray materialSamplers[3];
+layout (binding = 1) uniform sampler2DArrayShadow cascadeShadowSampler;
+layout (binding = 2) uniform sampler2DShadow spotShadowSampler;
+
+#ifdef WEIGHTED_OIT
+layout(location = 0) out vec4 accumulation;
+layout(location = 1) out float revealage;
+#else
 out vec4 FragColor;
+#endif
 
 float computeSpot(in float openingAngle, in float exponent, in vec3 spotDir, in vec3 lightDir, in vec3 normal)
 {
@@ -85,6 +138,70 @@ float computeSpot(in float openingAngle, in float exponent, in vec3 spotDir, in
     return spotFactor;
 }
 
+float computeDirShadow(in vec3 normal)
+{
+    float depth = -lightsIn.obsPos.z;
+    if (depth > cascadeSplits[nCascades - 1])
+        return 1.0;
+
+    int cascade = 0;
+    while (cascade < nCascades - 1 && depth > cascadeSplits[cascade])
+        cascade++;
+
+    vec4 coords = cascadeMatrices[cascade] * vec4(lightsIn.obsPos + normal * SHADOW_NORMAL_OFFSET, 1.0);
+    return texture(cascadeShadowSampler, vec4(coords.xy, float(cascade), coords.z));
+}
+
+float computeSpotShadow(in int shadowMapIndex, in vec3 normal)
+{
+    if (shadowMapIndex < 0)
+        return 1.0;
+
+    vec4 coords = spotShadowMatrices[shadowMapIndex] * vec4(lightsIn.obsPos + normal * SHADOW_NORMAL_OFFSET, 1.0);
+    return textureProj(spotShadowSampler, coords);
+}
+
+uint getClusterIndex()
+{
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / clusterTileSize), clusterGridSize.xy - 1u);
+    float slice = log(-lightsIn.obsPos.z) * clusterDepthParams.x - clusterDepthParams.y;
+    uint z = min(uint(max(slice, 0.0)), clusterGridSize.z - 1u);
+    return tile.x + clusterGridSize.x * (tile.y + clusterGridSize.y * z);
+}
+
+// materialTexture: le tableau dans les bits 8 et plus, la couche dans les bits 0 à 7.
+// L'indice du tableau n'est pas uniforme, d'où les branches à indice constant; les
+// dérivées sont donc prises avant et le biais de LOD y est appliqué.
+vec4 sampleMaterialTexture(in int materialTexture, in vec2 texCoords, in bool isClamped, in float lodBias)
+{
+    int array = materialTexture >> 8;
+    float layer = float(materialTexture & 0xFF);
+    vec2 dx = dFdx(texCoords) * exp2(lodBias);
+    vec2 dy = dFdy(texCoords) * exp2(lodBias);
+
+    if (isClamped)
+    {
+        // Émule GL_CLAMP_TO_EDGE, les tableaux étant en GL_REPEAT. Le demi-texel est
+        // celui du niveau le plus grossier lu, sinon les bords débordent aux petits niveaux.
+        vec2 size;
+        if (array == 0)
+            size = vec2(textureSize(materialSamplers[0], 0).xy);
+        else if (array == 1)
+            size = vec2(textureSize(materialSamplers[1], 0).xy);
+        else
+            size = vec2(textureSize(materialSamplers[2], 0).xy);
+        float lod = ceil(max(0.0, log2(max(length(dx * size), length(dy * size)))));
+        vec2 halfTexel = min(vec2(0.5), 0.5 * exp2(lod) / size);
+        texCoords = clamp(texCoords, halfTexel, 1.0 - halfTexel);
+    }
+
+    if (array == 0)
+        return textureGrad(materialSamplers[0], vec3(texCoords, layer), dx, dy);
+    if (array == 1)
+        return textureGrad(materialSamplers[1], vec3(texCoords, layer), dx, dy);
+    return textureGrad(materialSamplers[2], vec3(texCoords, layer), dx, dy);
+}
+
 void main()
 {
     vec3 N = normalize(attribsIn.normal);
@@ -101,17 +218,23 @@ void main()
     float cel_diff = floor(diff_dir * LEVELS) / LEVELS;
     float cel_spec = floor(spec_dir * LEVELS) / LEVELS;
     
+    float dirShadow = diff_dir > 0.0 ? computeDirShadow(N) : 1.0;
+    
     vec3 totalAmbient  = globalAmbient * mat.ambient + dirLight.ambient * mat.ambient;
-    vec3 totalDiffuse  = dirLight.diffuse * mat.diffuse * cel_diff;
-    vec3 totalSpecular = dirLight.specular * mat.specular * cel_spec;
+    vec3 totalDiffuse  = dirLight.diffuse * mat.diffuse * cel_diff * dirShadow;
+    vec3 totalSpecular = dirLight.specular * mat.specular * cel_spec * dirShadow;
     
-    for(int i = 0; i < nSpotLights; i++)
+    uint clusterOffset = getClusterIndex() * (MAX_LIGHTS_PER_CLUSTER + 1);
+    uint nClusterLights = clusterLights[clusterOffset];
+    for(uint k = 0u; k < nClusterLights; k++)
     {
-        vec3 L_spot = lightsIn.spotLightsDir[i];
+        uint i = clusterLights[clusterOffset + 1u + k];
+        
+        vec3 L_spot = (view * vec4(spotLights[i].position, 1.0)).xyz - lightsIn.obsPos;
         float distanceToLight = length(L_spot);
         L_spot = normalize(L_spot);
         
-        vec3 spotDir = lightsIn.spotLightsSpotDir[i];
+        vec3 spotDir = mat3(view) * spotLights[i].direction;
         
         float spotFactor = computeSpot(spotLights[i].openingAngle, spotLights[i].exponent, spotDir, L_spot, N);
         
@@ -123,10 +246,11 @@ void main()
             if (diff_spot == 0.0) spec_spot = 0.0;
             
             float attenuation = 1.0 - smoothstep(7.0, 10.0, distanceToLight);
+            float shadow = computeSpotShadow(spotLights[i].shadowMapIndex, N);
             
             vec3 spotAmbient  = spotLights[i].ambient * mat.ambient;
-            vec3 spotDiffuse  = spotLights[i].diffuse * mat.diffuse * diff_spot * spotFactor;
-            vec3 spotSpecular = spotLights[i].specular * mat.specular * spec_spot * spotFactor;
+            vec3 spotDiffuse  = spotLights[i].diffuse * mat.diffuse * diff_spot * spotFactor * shadow;
+            vec3 spotSpecular = spotLights[i].specular * mat.specular * spec_spot * spotFactor * shadow;
             
             totalAmbient  += spotAmbient * attenuation;
             totalDiffuse  += spotDiffuse * attenuation;
@@ -134,10 +258,18 @@ void main()
         }
     }
 
-    vec4 texColor = texture(diffuseSampler, attribsIn.texCoords);
+    vec4 texColor = sampleMaterialTexture(mat.textureLayer, attribsIn.texCoords, mat.isTextureClamped, mat.textureLodBias);
     vec3 baseColor = texColor.rgb * attribsIn.color; 
 
     vec3 color = mat.emission + baseColor * (totalAmbient + totalDiffuse) + totalSpecular;
     
+#ifdef WEIGHTED_OIT
+    // Poids de McGuire et Bavoil: les surfaces proches dominent la moyenne.
+    float alpha = texColor.a;
+    float weight = alpha * clamp(3e3 * pow(1.0 - gl_FragCoord.z, 3.0), 1e-2, 3e3);
+    accumulation = vec4(color * alpha, alpha) * weight;
+    revealage = alpha;
+#else
     FragColor = vec4(color, texColor.a);
+#endif
 }
@@ -1,11 +1,10 @@
-#version 330 core
+#version 430 core
 
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec3 color;
 layout (location = 2) in vec3 normal;
 layout (location = 3) in vec2 texCoords;
 
-#define MAX_SPOT_LIGHTS 12
 
 out ATTRIBS_VS_OUT
 {
@@ -18,15 +17,28 @@ out LIGHTS_VS_OUT
 {
     vec3 obsPos;
     vec3 dirLightDir;
-    
-    vec3 spotLightsDir[MAX_SPOT_LIGHTS];
-    vec3 spotLightsSpotDir[MAX_SPOT_LIGHTS];
 } lightsOut;
 
-uniform mat4 mvp;
+// Indice de la transformation de l'objet dans InstanceBlock (gl_InstanceID + baseInstance).
+layout (location = 4) in uint instanceIndex;
+
+struct Instance
+{
+    mat4 model;
+    uint materialIndex;
+};
+
+layout (std430, binding = 2) readonly buffer InstanceBlock
+{
+    Instance instances[];
+};
+
+uniform mat4 projView;
 uniform mat4 view;
-uniform mat4 modelView;
-uniform mat3 normalMatrix;
+
+#ifdef MATERIAL_TABLE
+flat out uint materialIndex;
+#endif
 
 struct Material
 {
@@ -35,44 +47,43 @@ struct Material
     vec3 diffuse;
     vec3 specular;
     float shininess;
-};
 
-struct DirectionalLight
-{
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-    
-    vec3 direction;
+    int textureLayer;
+    bool isTextureClamped;
+    float textureLodBias;
 };
 
-struct SpotLight
+struct DirectionalLight
 {
     vec3 ambient;
     vec3 diffuse;
     vec3 specular;
     
-    vec3 position;
     vec3 direction;
-    float exponent;
-    float openingAngle;
 };
 
-uniform int nSpotLights;
-
+#ifndef MATERIAL_TABLE
 layout (std140) uniform MaterialBlock
 {
     Material mat;
 };
+#endif
 
 layout (std140) uniform LightingBlock
 {
     DirectionalLight dirLight;
-    SpotLight spotLights[MAX_SPOT_LIGHTS];
 };
 
 void main()
 {
+    Instance instance = instances[instanceIndex];
+    mat4 modelView = view * instance.model;
+    mat3 normalMatrix = transpose(inverse(mat3(modelView)));
+    mat4 mvp = projView * instance.model;
+#ifdef MATERIAL_TABLE
+    materialIndex = instance.materialIndex;
+#endif
+
     attribsOut.texCoords = texCoords;
 
     attribsOut.texCoords = texCoords;
@@ -93,12 +104,5 @@ void main()
     lightsOut.obsPos = posInView.xyz;
 
     lightsOut.dirLightDir = normalize(mat3(view) * dirLight.direction);
-
-    for(int i = 0; i < nSpotLights; i++)
-    {
-        vec4 spotPosInView = view * vec4(spotLights[i].position, 1.0);
-        lightsOut.spotLightsDir[i] = spotPosInView.xyz - posInView.xyz;
-        lightsOut.spotLightsSpotDir[i] = normalize(mat3(view) * spotLights[i].direction);
-    }
     gl_Position = mvp * vec4(position, 1.0);
 }
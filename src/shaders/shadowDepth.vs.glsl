@@ -0,0 +1,23 @@
+#version 430 core
+
+layout (location = 0) in vec3 position;
+
+layout (location = 4) in uint instanceIndex;
+
+struct Instance
+{
+    mat4 model;
+    uint materialIndex;
+};
+
+layout (std430, binding = 2) readonly buffer InstanceBlock
+{
+    Instance instances[];
+};
+
+uniform mat4 lightProjView;
+
+void main()
+{
+    gl_Position = lightProjView * instances[instanceIndex].model * vec4(position, 1.0);
+}
@@ -0,0 +1,54 @@
+#version 430 core
+
+#include "depth.h"
+
+in vec2 texCoords;
+
+// Cibles de TransparencyPass: les particules s'ajoutent aux autres surfaces
+// transparentes et sont composées avec elles.
+layout(location = 0) out vec4 accumulationOut;
+layout(location = 1) out float revealageOut;
+
+layout(binding = 4) uniform sampler2D accumulation;
+layout(binding = 5) uniform sampler2D revealage;
+layout(binding = 6) uniform sampler2D particleDepth;
+layout(binding = 7) uniform sampler2D sceneDepth;
+
+uniform int downscale;
+
+void main()
+{
+    float distance = linearDepth(texelFetch(sceneDepth, ivec2(gl_FragCoord.xy), 0).r);
+
+    // Quatre texels réduits les plus proches, pondérés comme un filtre
+    // bilinéaire et par la ressemblance de leur profondeur à celle du pixel.
+    vec2 lowPosition = gl_FragCoord.xy / float(downscale) - 0.5;
+    ivec2 base = ivec2(floor(lowPosition));
+    vec2 f = lowPosition - vec2(base);
+    ivec2 lowSize = textureSize(accumulation, 0);
+
+    vec4 sum = vec4(0.0);
+    float reveal = 0.0;
+    float totalWeight = 0.0;
+    for (int i = 0; i < 4; i++)
+    {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        ivec2 texel = clamp(base + offset, ivec2(0), lowSize - 1);
+        vec2 bilinear = mix(1.0 - f, f, vec2(offset));
+        float depthDifference = abs(texelFetch(particleDepth, texel, 0).r - distance) / distance;
+        float weight = bilinear.x * bilinear.y / (depthDifference + 1e-3);
+
+        sum += texelFetch(accumulation, texel, 0) * weight;
+        reveal += texelFetch(revealage, texel, 0).r * weight;
+        totalWeight += weight;
+    }
+    sum /= totalWeight;
+    reveal /= totalWeight;
+    if (reveal >= 1.0)
+        discard;
+
+    // Mêmes fusions que TransparencyPass: la somme s'ajoute, et 1 - reveal
+    // multiplie la revealage de la cible par celle des particules.
+    accumulationOut = sum;
+    revealageOut = 1.0 - reveal;
+}
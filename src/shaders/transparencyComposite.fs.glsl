@@ -0,0 +1,21 @@
+#version 430 core
+
+in vec2 texCoords;
+
+out vec4 FragColor;
+
+layout(binding = 4) uniform sampler2D accumulation;
+layout(binding = 5) uniform sampler2D revealage;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float reveal = texelFetch(revealage, texel, 0).r;
+    if (reveal >= 1.0)
+        discard;
+
+    // Moyenne pondérée des couleurs, mélangée selon la couverture totale.
+    vec4 sum = texelFetch(accumulation, texel, 0);
+    vec3 averageColor = sum.rgb / max(sum.a, 1e-5);
+    FragColor = vec4(averageColor, 1.0 - reveal);
+}
@@ -0,0 +1,326 @@
+#include "shadow_maps.hpp"
+
+#include "frustum_culling.hpp"
+#include "light_clusters.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+static_assert(ShadowMaps::MAX_CASCADES <= 4, "cascadeSplits est un vec4");
+
+// Mélange des découpages logarithmique et uniforme des cascades.
+static const float CASCADE_SPLIT_LAMBDA = 0.75f;
+static const float SPOT_SHADOW_NEAR = 0.1f;
+
+static void setShadowTextureParameters(GLenum target)
+{
+    // Hors de la carte, rien n'est dans l'ombre.
+    const GLfloat BORDER_COLOR[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    glTexParameterfv(target, GL_TEXTURE_BORDER_COLOR, BORDER_COLOR);
+    glTexParameteri(target, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(target, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+}
+
+ShadowMaps::ShadowMaps()
+: data_()
+, framebuffer_(0), cascadeTexture_(0), spotAtlasTexture_(0)
+, nCascades_(3), resolution_(2048), shadowDistance_(80.0f)
+, lightDirection_(0.0f, -1.0f, 0.0f)
+, isDirectionalLightEnabled_(true)
+, isSpotLightEnabled_()
+, nStaticCasters_(0)
+, commands_(GL_STREAM_DRAW)
+{
+}
+
+ShadowMaps::~ShadowMaps()
+{
+    glDeleteFramebuffers(1, &framebuffer_);
+    glDeleteTextures(1, &cascadeTexture_);
+    glDeleteTextures(1, &spotAtlasTexture_);
+}
+
+void ShadowMaps::init(GLuint uniformBindingIndex)
+{
+    shader_.create();
+
+    shadowBlock_.allocate(&data_, sizeof(ShadowData));
+    shadowBlock_.setBindingIndex(uniformBindingIndex);
+
+    glGenTextures(1, &cascadeTexture_);
+    glGenTextures(1, &spotAtlasTexture_);
+    allocateTextures();
+
+    glGenFramebuffers(1, &framebuffer_);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, spotAtlasTexture_, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "Shadow map framebuffer incomplete" << std::endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void ShadowMaps::reloadShader()
+{
+    shader_.create();
+}
+
+void ShadowMaps::setCascadeCount(GLuint count)
+{
+    count = std::clamp<GLuint>(count, 1, MAX_CASCADES);
+    if (count == nCascades_)
+        return;
+    nCascades_ = count;
+    allocateTextures();
+}
+
+GLuint ShadowMaps::getCascadeCount() const
+{
+    return nCascades_;
+}
+
+void ShadowMaps::setResolution(GLsizei resolution)
+{
+    if (resolution == resolution_)
+        return;
+    resolution_ = resolution;
+    allocateTextures();
+}
+
+GLsizei ShadowMaps::getResolution() const
+{
+    return resolution_;
+}
+
+void ShadowMaps::setShadowDistance(float distance)
+{
+    shadowDistance_ = distance;
+}
+
+void ShadowMaps::addStaticCaster(const Model& model, const InstanceRange& instances, const BoundingSphere& sphere)
+{
+    casters_.insert(casters_.begin() + nStaticCasters_, {&model, instances});
+    casterSpheres_.insert(casterSpheres_.begin() + nStaticCasters_, sphere);
+    nStaticCasters_++;
+    casterVisibility_.resize(casters_.size());
+}
+
+void ShadowMaps::beginFrame()
+{
+    casters_.resize(nStaticCasters_);
+    casterSpheres_.resize(nStaticCasters_);
+}
+
+void ShadowMaps::addCaster(const Model& model, const InstanceRange& instances, const BoundingSphere& sphere)
+{
+    casters_.push_back({&model, instances});
+    casterSpheres_.push_back(sphere);
+    casterVisibility_.resize(casters_.size());
+}
+
+void ShadowMaps::setDirectionalLight(const DirectionalLight& light)
+{
+    lightDirection_ = glm::normalize(glm::vec3(light.direction));
+    // L'ombre ne multiplie que les termes diffus et spéculaire.
+    isDirectionalLightEnabled_ = glm::vec3(light.diffuse) != glm::vec3(0.0f) || glm::vec3(light.specular) != glm::vec3(0.0f);
+}
+
+void ShadowMaps::setSpotLight(GLuint tile, const SpotLight* light)
+{
+    isSpotLightEnabled_[tile] = light != nullptr;
+    if (light)
+        spotLights_[tile] = *light;
+}
+
+void ShadowMaps::render(GeometryPool& pool, const glm::mat4& view, float fovY, float aspect, float zNear)
+{
+    glm::mat4 invView = glm::inverse(view);
+    updateCascades(invView, fovY, aspect, zNear);
+    updateSpotLights(invView);
+    shadowBlock_.updateData(&data_, 0, sizeof(ShadowData));
+
+    GLuint nDrawnCascades = isDirectionalLightEnabled_ ? nCascades_ : 0;
+    commands_.clear();
+    DrawCommandRange cascadeDraws[MAX_CASCADES];
+    for (GLuint i = 0; i < nDrawnCascades; i++)
+        cascadeDraws[i] = cullCasters(cascadeProjViews_[i], true);
+    DrawCommandRange spotDraws[MAX_SHADOWED_SPOTLIGHTS];
+    for (GLuint i = 0; i < MAX_SHADOWED_SPOTLIGHTS; i++)
+    {
+        if (isSpotLightEnabled_[i])
+            spotDraws[i] = cullCasters(spotProjViews_[i], false);
+    }
+    commands_.upload();
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    shader_.use();
+    pool.bind();
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glDisable(GL_CULL_FACE);
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2.0f, 4.0f);
+
+    // Les objets entre la lumière et la cascade sont écrasés sur le plan proche
+    // au lieu d'être coupés, ce qui permet un volume serré autour de la tranche.
+    glEnable(GL_DEPTH_CLAMP);
+    glViewport(0, 0, resolution_, resolution_);
+    for (GLuint i = 0; i < nDrawnCascades; i++)
+    {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, cascadeTexture_, 0, i);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        drawPass(cascadeProjViews_[i], cascadeDraws[i]);
+    }
+    glDisable(GL_DEPTH_CLAMP);
+
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, spotAtlasTexture_, 0);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    GLsizei tileSize = resolution_ / 2;
+    for (GLuint i = 0; i < MAX_SHADOWED_SPOTLIGHTS; i++)
+    {
+        if (!isSpotLightEnabled_[i])
+            continue;
+        glViewport((i % 2) * tileSize, (i / 2) * tileSize, tileSize, tileSize);
+        drawPass(spotProjViews_[i], spotDraws[i]);
+    }
+
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glEnable(GL_CULL_FACE);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+void ShadowMaps::bindTextures()
+{
+    // Unités des samplers de phong.fs
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, cascadeTexture_);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, spotAtlasTexture_);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void ShadowMaps::allocateTextures()
+{
+    // Sur leurs propres unités, pour ne pas remplacer les textures liées à l'unité 0.
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, cascadeTexture_);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT32F, resolution_, resolution_, nCascades_, 0,
+                 GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    setShadowTextureParameters(GL_TEXTURE_2D_ARRAY);
+
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, spotAtlasTexture_);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, resolution_, resolution_, 0,
+                 GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    setShadowTextureParameters(GL_TEXTURE_2D);
+
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void ShadowMaps::updateCascades(const glm::mat4& invView, float fovY, float aspect, float zNear)
+{
+    const glm::mat4 TEXTURE_BIAS = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.5f)), glm::vec3(0.5f));
+
+    glm::vec3 up = std::abs(lightDirection_.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::mat4 lightRotation = glm::lookAt(glm::vec3(0.0f), lightDirection_, up);
+
+    float tanHalfFovY = std::tan(fovY * 0.5f);
+    float tanHalfFovX = tanHalfFovY * aspect;
+
+    float splitNear = zNear;
+    for (GLuint i = 0; i < nCascades_; i++)
+    {
+        float t = float(i + 1) / nCascades_;
+        float logSplit = zNear * std::pow(shadowDistance_ / zNear, t);
+        float uniformSplit = zNear + (shadowDistance_ - zNear) * t;
+        float splitFar = CASCADE_SPLIT_LAMBDA * logSplit + (1.0f - CASCADE_SPLIT_LAMBDA) * uniformSplit;
+
+        // Sphère englobant la tranche, centrée sur l'axe de vue: sa taille ne
+        // change pas quand la caméra tourne, ce qui évite le scintillement.
+        glm::vec3 corners[8];
+        glm::vec3 center(0.0f);
+        for (int j = 0; j < 8; j++)
+        {
+            float depth = j < 4 ? splitNear : splitFar;
+            corners[j] = glm::vec3((j & 1 ? 1.0f : -1.0f) * tanHalfFovX * depth,
+                                   (j & 2 ? 1.0f : -1.0f) * tanHalfFovY * depth,
+                                   -depth);
+            center += corners[j] / 8.0f;
+        }
+        float radius = 0.0f;
+        for (int j = 0; j < 8; j++)
+            radius = std::max(radius, glm::length(corners[j] - center));
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+
+        // Le centre est aligné sur les texels de la carte pour la même raison.
+        glm::vec3 lightCenter = glm::vec3(lightRotation * invView * glm::vec4(center, 1.0f));
+        float texelSize = 2.0f * radius / resolution_;
+        lightCenter.x = std::floor(lightCenter.x / texelSize) * texelSize;
+        lightCenter.y = std::floor(lightCenter.y / texelSize) * texelSize;
+
+        glm::mat4 lightView = glm::translate(glm::mat4(1.0f), -lightCenter) * lightRotation;
+        glm::mat4 lightProj = glm::ortho(-radius, radius, -radius, radius, -radius, radius);
+        cascadeProjViews_[i] = lightProj * lightView;
+
+        data_.cascadeMatrices[i] = TEXTURE_BIAS * cascadeProjViews_[i] * invView;
+        data_.cascadeSplits[i] = splitFar;
+        splitNear = splitFar;
+    }
+    data_.nCascades = nCascades_;
+}
+
+void ShadowMaps::updateSpotLights(const glm::mat4& invView)
+{
+    for (GLuint i = 0; i < MAX_SHADOWED_SPOTLIGHTS; i++)
+    {
+        if (!isSpotLightEnabled_[i])
+            continue;
+
+        const SpotLight& light = spotLights_[i];
+        glm::vec3 position(light.position);
+        glm::vec3 direction = glm::normalize(light.direction);
+        glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+        float fov = glm::radians(std::min(2.0f * light.openingAngle, 170.0f));
+        glm::mat4 lightProj = glm::perspective(fov, 1.0f, SPOT_SHADOW_NEAR, LightClusters::LIGHT_RADIUS);
+        glm::mat4 lightView = glm::lookAt(position, position + direction, up);
+        spotProjViews_[i] = lightProj * lightView;
+
+        // NDC -> coordonnées de la tuile dans l'atlas
+        glm::vec3 tileOffset(0.25f + 0.5f * (i % 2), 0.25f + 0.5f * (i / 2), 0.5f);
+        glm::mat4 tileBias = glm::scale(glm::translate(glm::mat4(1.0f), tileOffset), glm::vec3(0.25f, 0.25f, 0.5f));
+        data_.spotMatrices[i] = tileBias * spotProjViews_[i] * invView;
+    }
+}
+
+DrawCommandRange ShadowMaps::cullCasters(const glm::mat4& projView, bool isDepthClamped)
+{
+    Frustum frustum(projView, !isDepthClamped);
+    frustum.cull(casterSpheres_.data(), casters_.size(), casterVisibility_.data());
+
+    for (size_t i = 0; i < casters_.size(); i++)
+    {
+        if (casterVisibility_[i])
+            commands_.add(*casters_[i].model, casters_[i].instances);
+    }
+    return commands_.endGroup();
+}
+
+void ShadowMaps::drawPass(const glm::mat4& projView, const DrawCommandRange& draws)
+{
+    if (draws.count == 0)
+        return;
+    glUniformMatrix4fv(shader_.lightProjViewULoc, 1, GL_FALSE, glm::value_ptr(projView));
+    commands_.draw(draws);
+}
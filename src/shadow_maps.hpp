@@ -0,0 +1,112 @@
+#ifndef SHADOW_MAPS_H
+#define SHADOW_MAPS_H
+
+#include <cstdint>
+#include <vector>
+
+#include <glbinding/gl/gl.h>
+#include <glm/glm.hpp>
+
+#include "geometry_pool.hpp"
+#include "light_manager.hpp"
+#include "model.hpp"
+#include "shaders.hpp"
+#include "uniform_buffer.hpp"
+
+using namespace gl;
+
+// Cartes d'ombres de la lumière directionnelle (en cascades, dans un tableau de
+// textures) et des projecteurs (tuiles d'un atlas). Les objets qui projettent
+// une ombre sont enregistrés avec leur sphère englobante; chaque passe ne dessine
+// que ceux qui touchent son volume, en un seul dessin indirect.
+class ShadowMaps
+{
+public:
+    static constexpr GLuint MAX_CASCADES = 4;
+    // Atlas de 2x2 tuiles
+    static constexpr GLuint MAX_SHADOWED_SPOTLIGHTS = 4;
+
+    ShadowMaps();
+    ~ShadowMaps();
+
+    void init(GLuint uniformBindingIndex);
+    void reloadShader();
+
+    // Réglages: moins de cascades ou une résolution plus basse allègent les passes.
+    void setCascadeCount(GLuint count);
+    GLuint getCascadeCount() const;
+    // Côté des cascades et de l'atlas, en texels.
+    void setResolution(GLsizei resolution);
+    GLsizei getResolution() const;
+    // Profondeur de vue couverte par les cascades; au-delà, pas d'ombre.
+    void setShadowDistance(float distance);
+
+    // La sphère englobe toutes les instances, en coordonnées du monde.
+    void addStaticCaster(const Model& model, const InstanceRange& instances, const BoundingSphere& sphere);
+    // Retire les objets ajoutés par addCaster() à l'image précédente.
+    void beginFrame();
+    void addCaster(const Model& model, const InstanceRange& instances, const BoundingSphere& sphere);
+
+    // Les cascades ne sont pas dessinées si la lumière n'éclaire pas (la nuit).
+    void setDirectionalLight(const DirectionalLight& light);
+    // Le projecteur doit avoir shadowMapIndex == tile. nullptr libère la tuile.
+    void setSpotLight(GLuint tile, const SpotLight* light);
+
+    // Calcule les matrices pour la caméra, puis dessine toutes les cartes.
+    // Le tampon d'image et la fenêtre d'affichage sont restaurés à la fin.
+    void render(GeometryPool& pool, const glm::mat4& view, float fovY, float aspect, float zNear);
+
+    void bindTextures();
+
+private:
+    struct ShadowCaster
+    {
+        const Model* model;
+        InstanceRange instances;
+    };
+
+    // Disposition std140 de ShadowBlock. Les matrices vont de l'espace de vue
+    // aux coordonnées de texture des cartes.
+    struct ShadowData
+    {
+        glm::mat4 cascadeMatrices[MAX_CASCADES];
+        glm::mat4 spotMatrices[MAX_SHADOWED_SPOTLIGHTS];
+        glm::vec4 cascadeSplits;
+        GLint nCascades;
+        GLfloat padding[3];
+    };
+
+    void allocateTextures();
+    void updateCascades(const glm::mat4& invView, float fovY, float aspect, float zNear);
+    void updateSpotLights(const glm::mat4& invView);
+    DrawCommandRange cullCasters(const glm::mat4& projView, bool isDepthClamped);
+    void drawPass(const glm::mat4& projView, const DrawCommandRange& draws);
+
+private:
+    ShadowDepth shader_;
+    UniformBuffer shadowBlock_;
+    ShadowData data_;
+
+    GLuint framebuffer_;
+    GLuint cascadeTexture_;
+    GLuint spotAtlasTexture_;
+
+    GLuint nCascades_;
+    GLsizei resolution_;
+    float shadowDistance_;
+    glm::vec3 lightDirection_;
+    bool isDirectionalLightEnabled_;
+
+    glm::mat4 cascadeProjViews_[MAX_CASCADES];
+    glm::mat4 spotProjViews_[MAX_SHADOWED_SPOTLIGHTS];
+    SpotLight spotLights_[MAX_SHADOWED_SPOTLIGHTS];
+    bool isSpotLightEnabled_[MAX_SHADOWED_SPOTLIGHTS];
+
+    std::vector<ShadowCaster> casters_;
+    std::vector<BoundingSphere> casterSpheres_;
+    std::vector<uint8_t> casterVisibility_;
+    GLuint nStaticCasters_;
+    DrawCommandBuffer commands_;
+};
+
+#endif // SHADOW_MAPS_H
@@ -0,0 +1,159 @@
+#include "soft_particle_pass.hpp"
+
+#include <algorithm>
+
+#include "shaders/depth.h"
+
+// Unités des samplers de particleDepthDownsample.fs, particlesDraw.fs et
+// softParticleComposite.fs.
+static const GLuint ACCUMULATION_TEXTURE_UNIT = 4;
+static const GLuint REVEALAGE_TEXTURE_UNIT = 5;
+static const GLuint LINEAR_DEPTH_TEXTURE_UNIT = 6;
+static const GLuint SCENE_DEPTH_TEXTURE_UNIT = 7;
+
+SoftParticlePass::SoftParticlePass()
+: framebuffer_(0), depthFramebuffer_(0)
+, accumulationTexture_(0), revealageTexture_(0), linearDepthTexture_(0), sceneDepthTexture_(0)
+, vao_(0), width_(0), height_(0), downscale_(2), allocatedDownscale_(0)
+, depthParams_(0.0f)
+{
+}
+
+SoftParticlePass::~SoftParticlePass()
+{
+    glDeleteFramebuffers(1, &framebuffer_);
+    glDeleteFramebuffers(1, &depthFramebuffer_);
+    glDeleteTextures(1, &accumulationTexture_);
+    glDeleteTextures(1, &revealageTexture_);
+    glDeleteTextures(1, &linearDepthTexture_);
+    glDeleteVertexArrays(1, &vao_);
+}
+
+void SoftParticlePass::init()
+{
+    depthShader_.create();
+    compositeShader_.create();
+    glGenFramebuffers(1, &framebuffer_);
+    glGenFramebuffers(1, &depthFramebuffer_);
+    glGenVertexArrays(1, &vao_);
+}
+
+void SoftParticlePass::reloadShaders()
+{
+    depthShader_.create();
+    compositeShader_.create();
+}
+
+void SoftParticlePass::setDownscale(int downscale)
+{
+    downscale_ = std::max(1, std::min(downscale, MAX_DOWNSCALE));
+}
+
+int SoftParticlePass::getDownscale() const
+{
+    return downscale_;
+}
+
+void SoftParticlePass::begin(GLuint sceneDepthTexture, GLsizei width, GLsizei height, const glm::mat4& projection)
+{
+    if (width != width_ || height != height_ || downscale_ != allocatedDownscale_)
+        allocateTextures(width, height);
+
+    sceneDepthTexture_ = sceneDepthTexture;
+    depthParams_ = getDepthParams(projection);
+    GLsizei lowWidth = (width + downscale_ - 1) / downscale_;
+    GLsizei lowHeight = (height + downscale_ - 1) / downscale_;
+
+    glActiveTexture(GL_TEXTURE0 + SCENE_DEPTH_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, sceneDepthTexture_);
+    glActiveTexture(GL_TEXTURE0);
+
+    // Distance la plus proche de chaque bloc de pixels
+    glViewport(0, 0, lowWidth, lowHeight);
+    glBindFramebuffer(GL_FRAMEBUFFER, depthFramebuffer_);
+    depthShader_.use();
+    glUniform1i(depthShader_.downscaleULoc, downscale_);
+    glUniform2f(depthShader_.depthParamsULoc, depthParams_.x, depthParams_.y);
+    glDisable(GL_DEPTH_TEST);
+    glBindVertexArray(vao_);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+
+    glActiveTexture(GL_TEXTURE0 + LINEAR_DEPTH_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, linearDepthTexture_);
+    glActiveTexture(GL_TEXTURE0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    const GLfloat ZERO[] = {0.0f, 0.0f, 0.0f, 0.0f};
+    const GLfloat ONE[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    glClearBufferfv(GL_COLOR, 0, ZERO);
+    glClearBufferfv(GL_COLOR, 1, ONE);
+
+    // Le test de profondeur est fait par les particules avec la profondeur réduite.
+    glDepthMask(GL_FALSE);
+    glEnable(GL_BLEND);
+    glBlendFunci(0, GL_ONE, GL_ONE);
+    glBlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+}
+
+void SoftParticlePass::resolve()
+{
+    glActiveTexture(GL_TEXTURE0 + ACCUMULATION_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, accumulationTexture_);
+    glActiveTexture(GL_TEXTURE0 + REVEALAGE_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, revealageTexture_);
+    glActiveTexture(GL_TEXTURE0);
+
+    compositeShader_.use();
+    glUniform1i(compositeShader_.downscaleULoc, downscale_);
+    glUniform2f(compositeShader_.depthParamsULoc, depthParams_.x, depthParams_.y);
+    glBindVertexArray(vao_);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glEnable(GL_DEPTH_TEST);
+}
+
+void SoftParticlePass::allocateTextures(GLsizei width, GLsizei height)
+{
+    width_ = width;
+    height_ = height;
+    allocatedDownscale_ = downscale_;
+    GLsizei lowWidth = (width + downscale_ - 1) / downscale_;
+    GLsizei lowHeight = (height + downscale_ - 1) / downscale_;
+
+    glDeleteTextures(1, &accumulationTexture_);
+    glDeleteTextures(1, &revealageTexture_);
+    glDeleteTextures(1, &linearDepthTexture_);
+    GLuint textures[3];
+    glGenTextures(3, textures);
+    accumulationTexture_ = textures[0];
+    revealageTexture_ = textures[1];
+    linearDepthTexture_ = textures[2];
+
+    // Mêmes formats que TransparencyPass, plus la distance à la caméra.
+    glBindTexture(GL_TEXTURE_2D, accumulationTexture_);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, lowWidth, lowHeight);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glBindTexture(GL_TEXTURE_2D, revealageTexture_);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_R8, lowWidth, lowHeight);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glBindTexture(GL_TEXTURE_2D, linearDepthTexture_);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32F, lowWidth, lowHeight);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, accumulationTexture_, 0);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, revealageTexture_, 0);
+    const GLenum DRAW_BUFFERS[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, DRAW_BUFFERS);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, depthFramebuffer_);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, linearDepthTexture_, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
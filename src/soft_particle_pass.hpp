@@ -0,0 +1,58 @@
+#ifndef SOFT_PARTICLE_PASS_H
+#define SOFT_PARTICLE_PASS_H
+
+#include <glbinding/gl/gl.h>
+#include <glm/glm.hpp>
+
+#include "shaders.hpp"
+
+using namespace gl;
+
+// Particules dessinées à résolution réduite, avec transparence indépendante
+// de l'ordre comme TransparencyPass. La profondeur de la scène est d'abord
+// réduite à la même résolution; les particules s'estompent en approchant des
+// surfaces opaques. Le résultat est agrandi par un filtre bilatéral qui ne
+// mélange que les texels de profondeur voisine, puis ajouté aux cibles de
+// TransparencyPass pour être composé avec les autres surfaces transparentes.
+class SoftParticlePass
+{
+public:
+    static constexpr int MAX_DOWNSCALE = 4;
+
+    SoftParticlePass();
+    ~SoftParticlePass();
+
+    void init();
+    void reloadShaders();
+
+    // 1: pleine résolution, 2: demie, 4: quart.
+    void setDownscale(int downscale);
+    int getDownscale() const;
+
+    // Les nuanceurs de particules liés ensuite doivent écrire les deux
+    // sorties OIT et lire la profondeur réduite (SOFT_PARTICLES).
+    void begin(GLuint sceneDepthTexture, GLsizei width, GLsizei height, const glm::mat4& projection);
+    // Ajoute le résultat aux cibles liées par TransparencyPass::resume(), avant
+    // TransparencyPass::resolve().
+    void resolve();
+
+private:
+    void allocateTextures(GLsizei width, GLsizei height);
+
+private:
+    ParticleDepthDownsample depthShader_;
+    SoftParticleComposite compositeShader_;
+    GLuint framebuffer_;
+    GLuint depthFramebuffer_;
+    GLuint accumulationTexture_;
+    GLuint revealageTexture_;
+    GLuint linearDepthTexture_;
+    GLuint sceneDepthTexture_;
+    GLuint vao_;
+    GLsizei width_, height_;
+    int downscale_;
+    int allocatedDownscale_;
+    glm::vec2 depthParams_;
+};
+
+#endif // SOFT_PARTICLE_PASS_H
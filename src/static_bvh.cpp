@@ -0,0 +1,227 @@
+#include "static_bvh.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "frustum_culling.hpp"
+
+static const uint32_t MAX_LEAF_ITEMS = 4;
+static const int MAX_DEPTH = 64;
+
+void StaticBvh::build(const BoundingSphere* spheres, size_t count)
+{
+    spheres_.assign(spheres, spheres + count);
+    items_.resize(count);
+    for (uint32_t i = 0; i < count; i++)
+        items_[i] = i;
+
+    nodes_.clear();
+    nodes_.reserve(2 * count + 1);
+    nodes_.push_back({glm::vec3(0.0f), 0, glm::vec3(0.0f), (uint32_t)count, 0});
+    computeBounds(nodes_[0]);
+    subdivide(0);
+
+    // Les sphères sont rangées dans l'ordre des feuilles pour être testées par lots.
+    std::vector<BoundingSphere> leafSpheres(count);
+    for (uint32_t i = 0; i < count; i++)
+        leafSpheres[i] = spheres_[items_[i]];
+    spheres_ = std::move(leafSpheres);
+}
+
+void StaticBvh::computeBounds(Node& node) const
+{
+    node.min = glm::vec3(INFINITY);
+    node.max = glm::vec3(-INFINITY);
+    for (uint32_t i = node.firstItem; i < node.firstItem + node.nItems; i++)
+    {
+        const BoundingSphere& sphere = spheres_[items_[i]];
+        node.min = glm::min(node.min, sphere.center - sphere.radius);
+        node.max = glm::max(node.max, sphere.center + sphere.radius);
+    }
+}
+
+void StaticBvh::subdivide(uint32_t nodeIndex)
+{
+    Node node = nodes_[nodeIndex];
+    if (node.nItems <= MAX_LEAF_ITEMS)
+        return;
+
+    // Coupe au milieu des objets selon l'axe le plus long de leurs centres.
+    glm::vec3 centerMin(INFINITY);
+    glm::vec3 centerMax(-INFINITY);
+    for (uint32_t i = node.firstItem; i < node.firstItem + node.nItems; i++)
+    {
+        centerMin = glm::min(centerMin, spheres_[items_[i]].center);
+        centerMax = glm::max(centerMax, spheres_[items_[i]].center);
+    }
+    glm::vec3 extent = centerMax - centerMin;
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+    uint32_t* first = &items_[node.firstItem];
+    uint32_t nLeft = node.nItems / 2;
+    std::nth_element(first, first + nLeft, first + node.nItems, [this, axis](uint32_t a, uint32_t b)
+    {
+        return spheres_[a].center[axis] < spheres_[b].center[axis];
+    });
+
+    uint32_t left = nodes_.size();
+    nodes_.push_back({glm::vec3(0.0f), node.firstItem, glm::vec3(0.0f), nLeft, 0});
+    nodes_.push_back({glm::vec3(0.0f), node.firstItem + nLeft, glm::vec3(0.0f), node.nItems - nLeft, 0});
+    computeBounds(nodes_[left]);
+    computeBounds(nodes_[left + 1]);
+    nodes_[nodeIndex].left = left;
+
+    subdivide(left);
+    subdivide(left + 1);
+}
+
+void StaticBvh::cull(const Frustum& frustum, uint8_t* visible) const
+{
+    std::fill(visible, visible + spheres_.size(), 0);
+    if (nodes_.empty())
+        return;
+
+    uint32_t stack[MAX_DEPTH];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0)
+    {
+        const Node& node = nodes_[stack[--stackSize]];
+        Frustum::Containment containment = frustum.testBox(node.min, node.max);
+        if (containment == Frustum::OUTSIDE)
+            continue;
+
+        // Entièrement dedans: tout le sous-arbre est visible sans autre test.
+        if (containment == Frustum::INSIDE)
+        {
+            for (uint32_t i = node.firstItem; i < node.firstItem + node.nItems; i++)
+                visible[items_[i]] = 1;
+        }
+        else if (node.left == 0)
+        {
+            uint8_t leafVisible[MAX_LEAF_ITEMS];
+            frustum.cull(&spheres_[node.firstItem], node.nItems, leafVisible);
+            for (uint32_t i = 0; i < node.nItems; i++)
+                visible[items_[node.firstItem + i]] = leafVisible[i];
+        }
+        else
+        {
+            stack[stackSize++] = node.left;
+            stack[stackSize++] = node.left + 1;
+        }
+    }
+}
+
+static float distanceSquaredToBox(const glm::vec3& point, const glm::vec3& min, const glm::vec3& max)
+{
+    glm::vec3 delta = point - glm::max(min, glm::min(point, max));
+    return glm::dot(delta, delta);
+}
+
+uint32_t StaticBvh::findNearest(const glm::vec3& point, float maxDistance) const
+{
+    uint32_t nearest = INVALID_ITEM;
+    float nearestDistance = maxDistance;
+    if (nodes_.empty())
+        return nearest;
+
+    uint32_t stack[MAX_DEPTH];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0)
+    {
+        const Node& node = nodes_[stack[--stackSize]];
+        if (distanceSquaredToBox(point, node.min, node.max) >= nearestDistance * nearestDistance)
+            continue;
+
+        if (node.left == 0)
+        {
+            for (uint32_t i = node.firstItem; i < node.firstItem + node.nItems; i++)
+            {
+                const BoundingSphere& sphere = spheres_[i];
+                float distance = std::max(glm::length(point - sphere.center) - sphere.radius, 0.0f);
+                if (distance < nearestDistance)
+                {
+                    nearestDistance = distance;
+                    nearest = items_[i];
+                }
+            }
+            continue;
+        }
+
+        // L'enfant le plus proche est visité en premier pour resserrer la borne plus vite.
+        const Node& left = nodes_[node.left];
+        const Node& right = nodes_[node.left + 1];
+        bool isLeftCloser = distanceSquaredToBox(point, left.min, left.max) < distanceSquaredToBox(point, right.min, right.max);
+        stack[stackSize++] = isLeftCloser ? node.left + 1 : node.left;
+        stack[stackSize++] = isLeftCloser ? node.left : node.left + 1;
+    }
+    return nearest;
+}
+
+// Distance d'entrée du rayon dans la boîte, ou INFINITY s'il la manque.
+static float intersectBox(const glm::vec3& origin, const glm::vec3& inverseDirection,
+                          const glm::vec3& min, const glm::vec3& max)
+{
+    glm::vec3 t0 = (min - origin) * inverseDirection;
+    glm::vec3 t1 = (max - origin) * inverseDirection;
+    glm::vec3 tNear = glm::min(t0, t1);
+    glm::vec3 tFar = glm::max(t0, t1);
+    float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+    float exit = std::min(std::min(tFar.x, tFar.y), tFar.z);
+    return enter <= exit ? enter : INFINITY;
+}
+
+static float intersectSphere(const glm::vec3& origin, const glm::vec3& direction, const BoundingSphere& sphere)
+{
+    glm::vec3 toCenter = sphere.center - origin;
+    float projection = glm::dot(toCenter, direction);
+    float distanceSquared = glm::dot(toCenter, toCenter) - projection * projection;
+    float radiusSquared = sphere.radius * sphere.radius;
+    if (distanceSquared > radiusSquared)
+        return INFINITY;
+    float halfChord = std::sqrt(radiusSquared - distanceSquared);
+    float t = projection - halfChord >= 0.0f ? projection - halfChord : projection + halfChord;
+    return t >= 0.0f ? t : INFINITY;
+}
+
+uint32_t StaticBvh::raycast(const glm::vec3& origin, const glm::vec3& direction, float& distance, float maxDistance) const
+{
+    uint32_t hit = INVALID_ITEM;
+    distance = maxDistance;
+    if (nodes_.empty())
+        return hit;
+
+    glm::vec3 inverseDirection = glm::vec3(1.0f) / direction;
+    uint32_t stack[MAX_DEPTH];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0)
+    {
+        const Node& node = nodes_[stack[--stackSize]];
+        if (intersectBox(origin, inverseDirection, node.min, node.max) >= distance)
+            continue;
+
+        if (node.left == 0)
+        {
+            for (uint32_t i = node.firstItem; i < node.firstItem + node.nItems; i++)
+            {
+                float t = intersectSphere(origin, direction, spheres_[i]);
+                if (t < distance)
+                {
+                    distance = t;
+                    hit = items_[i];
+                }
+            }
+            continue;
+        }
+
+        const Node& left = nodes_[node.left];
+        const Node& right = nodes_[node.left + 1];
+        bool isLeftCloser = intersectBox(origin, inverseDirection, left.min, left.max)
+                          < intersectBox(origin, inverseDirection, right.min, right.max);
+        stack[stackSize++] = isLeftCloser ? node.left + 1 : node.left;
+        stack[stackSize++] = isLeftCloser ? node.left : node.left + 1;
+    }
+    return hit;
+}
@@ -0,0 +1,62 @@
+#ifndef STATIC_BVH_H
+#define STATIC_BVH_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "model.hpp"
+
+class Frustum;
+
+// Hiérarchie de volumes englobants construite une seule fois sur des objets
+// immobiles. Les objets sont désignés par leur indice dans le tableau de
+// sphères donné à build(); les requêtes ne visitent que les branches utiles.
+// Sert au culling sur le CPU lorsque le Hi-Z est désactivé, au choix du
+// lampadaire qui a une ombre et à la sélection à la souris.
+class StaticBvh
+{
+public:
+    static constexpr uint32_t INVALID_ITEM = ~0u;
+
+    void build(const BoundingSphere* spheres, size_t count);
+
+    // visible[i] = 1 si l'objet i touche le volume; visible doit avoir une
+    // entrée par objet. Les feuilles coupées par le volume sont testées avec
+    // Frustum::cull, par lots SSE.
+    void cull(const Frustum& frustum, uint8_t* visible) const;
+
+    // Objet dont la sphère est la plus proche du point, INVALID_ITEM si aucun
+    // n'est à moins de maxDistance.
+    uint32_t findNearest(const glm::vec3& point, float maxDistance = INFINITY) const;
+
+    // Premier objet dont la sphère coupe le rayon; distance reçoit la distance
+    // le long de direction (normalisée).
+    uint32_t raycast(const glm::vec3& origin, const glm::vec3& direction, float& distance, float maxDistance = INFINITY) const;
+
+private:
+    // Les objets d'un nœud sont contigus dans items_. Un nœud interne a ses
+    // deux enfants à left et left + 1; left == 0 pour une feuille.
+    struct Node
+    {
+        glm::vec3 min;
+        uint32_t firstItem;
+        glm::vec3 max;
+        uint32_t nItems;
+        uint32_t left;
+    };
+
+    void subdivide(uint32_t nodeIndex);
+    void computeBounds(Node& node) const;
+
+private:
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> items_;
+    // Dans l'ordre de items_ une fois build() terminé.
+    std::vector<BoundingSphere> spheres_;
+};
+
+#endif // STATIC_BVH_H
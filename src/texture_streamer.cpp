@@ -0,0 +1,164 @@
+#include "texture_streamer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "textures.hpp"
+
+TextureStreamer::TextureStreamer()
+: pbo_(0), mappedData_(nullptr), sliceSize_(0), currentSlice_(0)
+{
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    for (GLsync fence : fences_)
+    {
+        if (fence)
+            glDeleteSync(fence);
+    }
+    if (pbo_)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glDeleteBuffers(1, &pbo_);
+    }
+}
+
+void TextureStreamer::init(GLsizeiptr sliceSize, unsigned int nSlices)
+{
+    sliceSize_ = sliceSize;
+    fences_.assign(nSlices, nullptr);
+
+    glGenBuffers(1, &pbo_);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_);
+    glBufferStorage(GL_PIXEL_UNPACK_BUFFER, sliceSize_ * nSlices, nullptr,
+                    GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+    mappedData_ = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, sliceSize_ * nSlices,
+                                                   GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void TextureStreamer::enqueue(GLuint texture, GLenum bindTarget, GLenum imageTarget,
+                              std::shared_ptr<ImageData> image, std::function<void()> onComplete)
+{
+    jobs_.push_back({texture, bindTarget, imageTarget, std::move(image), std::move(onComplete), 0, -1});
+}
+
+bool TextureStreamer::isIdle() const
+{
+    return jobs_.empty();
+}
+
+void TextureStreamer::startJob(UploadJob& job)
+{
+    const ImageData& image = *job.image;
+    GLenum format = getFormat(image.nChannels);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture(job.bindTarget, job.texture);
+    if (image.levels.empty())
+        glTexImage2D(job.imageTarget, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+
+    for (size_t i = 0; i < image.levels.size(); i++)
+    {
+        const ImageLevel& level = image.levels[i];
+        if (image.compressedFormat != GL_NONE)
+            glCompressedTexImage2D(job.imageTarget, i, image.compressedFormat, level.width, level.height, 0, level.size, nullptr);
+        else
+            glTexImage2D(job.imageTarget, i, format, level.width, level.height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+    }
+    if (image.levels.size() > 1)
+        glTexParameteri(job.bindTarget, GL_TEXTURE_MAX_LEVEL, image.levels.size() - 1);
+
+    job.level = 0;
+    job.nextRow = 0;
+}
+
+// Copie des rangées [firstRow, firstRow + nRows) d'un niveau, depuis un pointeur ou un décalage dans le PBO lié.
+static void subImage(GLenum imageTarget, const ImageData& image, unsigned int levelIndex,
+                     int firstRow, int nRows, const void* data)
+{
+    const ImageLevel& level = image.levels[levelIndex];
+    if (image.compressedFormat != GL_NONE)
+    {
+        int y = firstRow * 4;
+        int height = std::min(nRows * 4, level.height - y);
+        glCompressedTexSubImage2D(imageTarget, levelIndex, 0, y, level.width, height, image.compressedFormat,
+                                  nRows * getRowSize(image, level), data);
+    }
+    else
+    {
+        glTexSubImage2D(imageTarget, levelIndex, 0, firstRow, level.width, nRows,
+                        getFormat(image.nChannels), GL_UNSIGNED_BYTE, data);
+    }
+}
+
+void TextureStreamer::update()
+{
+    if (jobs_.empty() || mappedData_ == nullptr)
+        return;
+
+    GLsync& fence = fences_[currentSlice_];
+    if (fence)
+    {
+        GLenum status = glClientWaitSync(fence, GL_NONE_BIT, 0);
+        if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED)
+            return;
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    UploadJob& job = jobs_.front();
+    if (job.nextRow < 0)
+        startJob(job);
+
+    const ImageData& image = *job.image;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(job.bindTarget, job.texture);
+
+    if (job.level < image.levels.size())
+    {
+        const ImageLevel& level = image.levels[job.level];
+        const unsigned char* levelData = image.pixels.data() + level.offset;
+        size_t rowSize = getRowSize(image, level);
+        int nLevelRows = getRowCount(image, level);
+
+        if (rowSize > (size_t)sliceSize_)
+        {
+            // Une rangée ne rentre pas dans une tranche: téléversement direct.
+            subImage(job.imageTarget, image, job.level, 0, nLevelRows, levelData);
+            job.nextRow = nLevelRows;
+        }
+        else
+        {
+            int nRows = std::min<int>(sliceSize_ / rowSize, nLevelRows - job.nextRow);
+            size_t sliceOffset = (size_t)currentSlice_ * sliceSize_;
+            std::memcpy(mappedData_ + sliceOffset, levelData + job.nextRow * rowSize, nRows * rowSize);
+
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo_);
+            subImage(job.imageTarget, image, job.level, job.nextRow, nRows, (const void*)sliceOffset);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+            fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, GL_NONE_BIT);
+            currentSlice_ = (currentSlice_ + 1) % fences_.size();
+            job.nextRow += nRows;
+        }
+
+        if (job.nextRow >= nLevelRows)
+        {
+            job.level++;
+            job.nextRow = 0;
+        }
+    }
+
+    if (job.level >= image.levels.size())
+    {
+        std::function<void()> onComplete = std::move(job.onComplete);
+        jobs_.pop_front();
+        if (onComplete)
+            onComplete();
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <glbinding/gl/gl.h>
+
+using namespace gl;
+
+struct ImageData;
+
+// Téléverse des images par bandes de rangées, niveau par niveau, à travers un
+// anneau de PBO mappés de façon persistante. Chaque trame remplit au plus une
+// tranche de l'anneau, ce qui borne le coût d'un téléversement par trame. Une
+// fence par tranche empêche d'écraser des données que le GPU n'a pas encore copiées.
+class TextureStreamer
+{
+public:
+    TextureStreamer();
+    ~TextureStreamer();
+
+    void init(GLsizeiptr sliceSize = 4 * 1024 * 1024, unsigned int nSlices = 3);
+
+    void enqueue(GLuint texture, GLenum bindTarget, GLenum imageTarget,
+                 std::shared_ptr<ImageData> image, std::function<void()> onComplete);
+
+    // À appeler une fois par trame.
+    void update();
+
+    bool isIdle() const;
+
+private:
+    struct UploadJob
+    {
+        GLuint texture;
+        GLenum bindTarget;
+        GLenum imageTarget;
+        std::shared_ptr<ImageData> image;
+        std::function<void()> onComplete;
+        unsigned int level;
+        int nextRow;
+    };
+
+    void startJob(UploadJob& job);
+
+private:
+    GLuint pbo_;
+    unsigned char* mappedData_;
+    GLsizeiptr sliceSize_;
+    unsigned int currentSlice_;
+    std::vector<GLsync> fences_;
+    std::deque<UploadJob> jobs_;
+};
+
+#endif // TEXTURE_STREAMER_H
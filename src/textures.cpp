@@ -2,10 +2,21 @@
 
 #include "stb_image.h"
 
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <string>
+
+#include "asset_loader.hpp"
+#include "dds.hpp"
+#include "texture_streamer.hpp"
+
+static const unsigned char PLACEHOLDER_PIXEL[4] = {128, 128, 128, 255};
 
 Texture2D::Texture2D()
-: m_id(0)
+: m_id(0), m_streamingId(0), m_nLevels(1), m_isUploaded(false), m_isMipmapEnabled(false)
+, m_minFilter(GL_NEAREST_MIPMAP_LINEAR), m_magFilter(GL_LINEAR), m_wrap(GL_REPEAT), m_lodBias(0.0f)
 {
 
 }
@@ -20,48 +31,252 @@ GLenum getFormat(int nChannels)
     return GL_RGBA;
 }
 
-void Texture2D::load(const char* path)
+size_t getRowSize(const ImageData& image, const ImageLevel& level)
 {
-    int width, height, nChannels;
-    stbi_set_flip_vertically_on_load(true);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    unsigned char* data = stbi_load(path, &width, &height, &nChannels, 0);
+    if (image.compressedFormat == GL_NONE)
+        return (size_t)level.width * image.nChannels;
+    return level.size / getRowCount(image, level);
+}
+
+int getRowCount(const ImageData& image, const ImageLevel& level)
+{
+    if (image.compressedFormat == GL_NONE)
+        return level.height;
+    return std::max(1, (level.height + 3) / 4);
+}
+
+static GLenum getCompressedFormat(DdsFormat format)
+{
+    switch (format)
+    {
+        case DdsFormat::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case DdsFormat::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case DdsFormat::BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        case DdsFormat::RGBA8: return GL_NONE;
+    }
+    return GL_NONE;
+}
+
+static bool isCompressedImageUpToDate(const std::filesystem::path& path, const std::filesystem::path& ddsPath)
+{
+    std::error_code error;
+    if (!std::filesystem::exists(ddsPath, error))
+        return false;
+    if (!std::filesystem::exists(path, error))
+        return true;
+    return std::filesystem::last_write_time(ddsPath, error) >= std::filesystem::last_write_time(path, error);
+}
+
+static bool decodeCompressedImage(const char* path, ImageData& image)
+{
+    DdsImage dds;
+    if (!readDds(path, dds))
+        return false;
+
+    image.width = dds.width;
+    image.height = dds.height;
+    image.nChannels = dds.format == DdsFormat::BC1 ? 3 : 4;
+    image.compressedFormat = getCompressedFormat(dds.format);
+    image.levels.clear();
+    for (const DdsLevel& level : dds.levels)
+        image.levels.push_back({(int)level.width, (int)level.height, level.offset, level.size});
+    image.pixels = std::move(dds.data);
+    return true;
+}
+
+// Le retournement vertical est fait ici plutôt qu'avec stbi_set_flip_vertically_on_load,
+// qui est un état global et donc pas sécuritaire lorsque plusieurs fils décodent en même temps.
+static bool loadPixels(const char* path, bool flipVertically, int desiredChannels, ImageData& image)
+{
+    unsigned char* data = stbi_load(path, &image.width, &image.height, &image.nChannels, desiredChannels);
     if (data == NULL)
+    {
         std::cout << "Error loading texture \"" << path << "\": " << stbi_failure_reason() << std::endl;
+        image.width = image.height = 0;
+        image.nChannels = 4;
+        return false;
+    }
+    if (desiredChannels != 0)
+        image.nChannels = desiredChannels;
 
-    GLenum format = getFormat(nChannels);
-    glGenTextures(1, &m_id);
-    glBindTexture(GL_TEXTURE_2D, m_id);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+    size_t rowSize = (size_t)image.width * image.nChannels;
+    image.pixels.resize(rowSize * image.height);
+    for (int y = 0; y < image.height; y++)
+    {
+        int srcY = flipVertically ? image.height - 1 - y : y;
+        std::memcpy(&image.pixels[y * rowSize], data + srcY * rowSize, rowSize);
+    }
+    image.levels.push_back({image.width, image.height, 0, image.pixels.size()});
 
     stbi_image_free(data);
+    return true;
+}
+
+std::shared_ptr<ImageData> decodeImage(const char* path, bool flipVertically)
+{
+    auto image = std::make_shared<ImageData>();
+    image->compressedFormat = GL_NONE;
+
+    std::filesystem::path ddsPath = std::filesystem::path(path).replace_extension(".dds");
+    if (isCompressedImageUpToDate(path, ddsPath) && decodeCompressedImage(ddsPath.string().c_str(), *image))
+        return image;
+
+    loadPixels(path, flipVertically, 0, *image);
+    return image;
+}
+
+// Téléverse tous les niveaux présents dans l'image. La texture doit être liée.
+static void uploadImage(GLenum bindTarget, GLenum imageTarget, const ImageData& image)
+{
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (image.levels.empty())
+    {
+        GLenum format = getFormat(image.nChannels);
+        glTexImage2D(imageTarget, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+        return;
+    }
+
+    for (size_t i = 0; i < image.levels.size(); i++)
+    {
+        const ImageLevel& level = image.levels[i];
+        const unsigned char* data = image.pixels.data() + level.offset;
+        if (image.compressedFormat != GL_NONE)
+        {
+            glCompressedTexImage2D(imageTarget, i, image.compressedFormat, level.width, level.height, 0, level.size, data);
+        }
+        else
+        {
+            GLenum format = getFormat(image.nChannels);
+            glTexImage2D(imageTarget, i, format, level.width, level.height, 0, format, GL_UNSIGNED_BYTE, data);
+        }
+    }
+    if (image.levels.size() > 1)
+        glTexParameteri(bindTarget, GL_TEXTURE_MAX_LEVEL, image.levels.size() - 1);
+}
+
+void Texture2D::load(const char* path)
+{
+    if (!m_id)
+        glGenTextures(1, &m_id);
+    upload(*decodeImage(path, true));
+}
+
+void Texture2D::load(const char* path, AssetLoader& loader)
+{
+    if (!m_id)
+        glGenTextures(1, &m_id);
+
+    std::string pathStr = path;
+    loader.enqueue(pathStr, [this, pathStr]() -> AssetLoader::UploadFunction
+    {
+        std::shared_ptr<ImageData> image = decodeImage(pathStr.c_str(), true);
+        return [this, image]() { upload(*image); };
+    });
+}
+
+void Texture2D::load(const char* path, AssetLoader& loader, TextureStreamer& streamer)
+{
+    if (!m_id)
+        glGenTextures(1, &m_id);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_2D, m_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_PIXEL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    m_isUploaded = false;
+
+    std::string pathStr = path;
+    loader.enqueue(pathStr, [this, pathStr, &streamer]() -> AssetLoader::UploadFunction
+    {
+        std::shared_ptr<ImageData> image = decodeImage(pathStr.c_str(), true);
+        return [this, image, &streamer]()
+        {
+            m_nLevels = std::max<size_t>(1, image->levels.size());
+            GLuint streamingId;
+            glGenTextures(1, &streamingId);
+            m_streamingId = streamingId;
+            streamer.enqueue(streamingId, GL_TEXTURE_2D, GL_TEXTURE_2D, image, [this, streamingId]()
+            {
+                glDeleteTextures(1, &m_id);
+                m_id = streamingId;
+                m_streamingId = 0;
+                m_isUploaded = true;
+                applyParameters();
+                if (m_isMipmapEnabled && m_nLevels == 1)
+                    glGenerateMipmap(GL_TEXTURE_2D);
+            });
+        };
+    });
+}
+
+void Texture2D::upload(const ImageData& image)
+{
+    glBindTexture(GL_TEXTURE_2D, m_id);
+    uploadImage(GL_TEXTURE_2D, GL_TEXTURE_2D, image);
+
+    m_nLevels = std::max<size_t>(1, image.levels.size());
+    m_isUploaded = true;
+    if (m_isMipmapEnabled && m_nLevels == 1)
+        glGenerateMipmap(GL_TEXTURE_2D);
 }
 
 Texture2D::~Texture2D()
 {
     glDeleteTextures(1, &m_id);
+    if (m_streamingId)
+        glDeleteTextures(1, &m_streamingId);
 }
 
 void Texture2D::setFiltering(GLenum filteringMode)
 {
+    m_magFilter = filteringMode;
+    m_minFilter = getMinFilter();
     glBindTexture(GL_TEXTURE_2D, m_id);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filteringMode);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filteringMode);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_minFilter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, m_magFilter);
 }
 
 void Texture2D::setWrap(GLenum wrapMode)
 {
+    m_wrap = wrapMode;
     glBindTexture(GL_TEXTURE_2D, m_id);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapMode);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapMode);
 }
 
+void Texture2D::setLodBias(float bias)
+{
+    m_lodBias = bias;
+    glBindTexture(GL_TEXTURE_2D, m_id);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_LOD_BIAS, bias);
+}
+
+// Les niveaux viennent normalement du .dds; glGenerateMipmap ne sert que si l'image n'en a pas.
 void Texture2D::enableMipmap()
+{
+    m_isMipmapEnabled = true;
+    m_minFilter = getMinFilter();
+    glBindTexture(GL_TEXTURE_2D, m_id);
+    if (m_isUploaded && m_nLevels == 1)
+        glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_minFilter);
+}
+
+GLenum Texture2D::getMinFilter() const
+{
+    if (!m_isMipmapEnabled)
+        return m_magFilter;
+    return m_magFilter == GL_NEAREST ? GL_NEAREST_MIPMAP_NEAREST : GL_LINEAR_MIPMAP_LINEAR;
+}
+
+void Texture2D::applyParameters()
 {
     glBindTexture(GL_TEXTURE_2D, m_id);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_minFilter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, m_magFilter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, m_wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, m_wrap);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_LOD_BIAS, m_lodBias);
 }
 
 void Texture2D::use()
@@ -70,55 +285,238 @@ void Texture2D::use()
 }
 
 //
-// Cubemap
+// Tableau de textures
 //
 
-TextureCubeMap::TextureCubeMap()
-: m_id(0)
+Texture2DArray::Texture2DArray()
+: m_id(0), m_size(0), m_nLevels(0), m_internalFormat(GL_NONE)
 {
 
 }
 
-void TextureCubeMap::load(const char** pathes)
+Texture2DArray::~Texture2DArray()
 {
-    const size_t N_TEXTURES = 6;
-    unsigned char* datas[N_TEXTURES];
-    int widths[N_TEXTURES];
-    int heights[N_TEXTURES];
-    int nChannels[N_TEXTURES];
-    stbi_set_flip_vertically_on_load(false);
-    for (unsigned int i = 0; i < 6; i++)
+    glDeleteTextures(1, &m_id);
+}
+
+// Un bloc BC3 gris opaque: alpha 255 partout, couleurs 0x8410 et indices à 0.
+static const unsigned char PLACEHOLDER_BC3_BLOCK[16] = {255, 255, 0, 0, 0, 0, 0, 0, 0x10, 0x84, 0x10, 0x84, 0, 0, 0, 0};
+
+void Texture2DArray::allocate(int size, int nLayers, GLenum internalFormat)
+{
+    m_size = size;
+    m_internalFormat = internalFormat;
+    m_nLevels = 1;
+    while ((size >> m_nLevels) > 0)
+        m_nLevels++;
+
+    glGenTextures(1, &m_id);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_id);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, m_nLevels, internalFormat, size, size, nLayers);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    bool isCompressed = internalFormat != GL_RGBA8;
+    std::vector<unsigned char> placeholder;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int i = 0; i < m_nLevels; i++)
     {
-        datas[i] = stbi_load(pathes[i], &widths[i], &heights[i], &nChannels[i], 0);
-        if (datas[i] == NULL)
-            std::cout << "Error loading texture \"" << pathes[i] << "\": " << stbi_failure_reason() << std::endl;
+        int levelSize = std::max(1, size >> i);
+        if (isCompressed)
+        {
+            int nBlocks = (levelSize + 3) / 4;
+            placeholder.resize((size_t)nBlocks * nBlocks * nLayers * sizeof(PLACEHOLDER_BC3_BLOCK));
+            for (size_t j = 0; j < placeholder.size(); j += sizeof(PLACEHOLDER_BC3_BLOCK))
+                std::memcpy(&placeholder[j], PLACEHOLDER_BC3_BLOCK, sizeof(PLACEHOLDER_BC3_BLOCK));
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, 0, levelSize, levelSize, nLayers,
+                                      internalFormat, placeholder.size(), placeholder.data());
+        }
+        else
+        {
+            placeholder.resize((size_t)levelSize * levelSize * nLayers * 4);
+            for (size_t j = 0; j < placeholder.size(); j += 4)
+                std::memcpy(&placeholder[j], PLACEHOLDER_PIXEL, 4);
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, 0, levelSize, levelSize, nLayers,
+                            GL_RGBA, GL_UNSIGNED_BYTE, placeholder.data());
+        }
     }
+}
 
-    glGenTextures(1, &m_id);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_id);
+bool Texture2DArray::isLayerImageValid(const char* path, const ImageData& image) const
+{
+    bool isFormatValid = m_internalFormat == GL_RGBA8
+                       ? image.compressedFormat == GL_NONE && image.nChannels == 4
+                       : image.compressedFormat == m_internalFormat;
+    if (isFormatValid && image.width == m_size && image.height == m_size && (int)image.levels.size() == m_nLevels)
+        return true;
+
+    std::cout << "Error loading texture layer \"" << path << "\": must be a " << m_size << "x" << m_size
+              << (m_internalFormat == GL_RGBA8 ? " RGBA8" : " BC3") << " .dds with all its mipmaps, built by TextureCompressor --size "
+              << m_size << std::endl;
+    return false;
+}
+
+void Texture2DArray::uploadLayer(int layer, const ImageData& image)
+{
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_id);
+    for (size_t i = 0; i < image.levels.size(); i++)
+    {
+        const ImageLevel& level = image.levels[i];
+        const unsigned char* data = image.pixels.data() + level.offset;
+        if (image.compressedFormat != GL_NONE)
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, layer, level.width, level.height, 1,
+                                      image.compressedFormat, level.size, data);
+        else
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, layer, level.width, level.height, 1,
+                            GL_RGBA, GL_UNSIGNED_BYTE, data);
+    }
+}
+
+void Texture2DArray::loadLayer(int layer, const char* path, AssetLoader& loader)
+{
+    std::string pathStr = path;
+    loader.enqueue(pathStr, [this, layer, pathStr]() -> AssetLoader::UploadFunction
+    {
+        std::shared_ptr<ImageData> image = decodeImage(pathStr.c_str(), true);
+        if (!isLayerImageValid(pathStr.c_str(), *image))
+            return nullptr;
+        return [this, layer, image]() { uploadLayer(layer, *image); };
+    });
+}
+
+void Texture2DArray::loadLayer(int layer, const char* path, AssetLoader& loader, TextureStreamer& streamer)
+{
+    std::string pathStr = path;
+    loader.enqueue(pathStr, [this, layer, pathStr, &streamer]() -> AssetLoader::UploadFunction
+    {
+        std::shared_ptr<ImageData> image = decodeImage(pathStr.c_str(), true);
+        if (!isLayerImageValid(pathStr.c_str(), *image))
+            return nullptr;
+        return [this, layer, image, &streamer]() { streamLayer(layer, image, streamer); };
+    });
+}
+
+// Les niveaux arrivent un par trame: la couche garde tous ses niveaux gris
+// jusqu'à ce que la chaîne complète y soit copiée.
+void Texture2DArray::streamLayer(int layer, std::shared_ptr<ImageData> image, TextureStreamer& streamer)
+{
+    GLuint stagingId;
+    glGenTextures(1, &stagingId);
+    streamer.enqueue(stagingId, GL_TEXTURE_2D, GL_TEXTURE_2D, image, [this, layer, image, stagingId]() mutable
+    {
+        for (size_t i = 0; i < image->levels.size(); i++)
+        {
+            const ImageLevel& level = image->levels[i];
+            glCopyImageSubData(stagingId, GL_TEXTURE_2D, i, 0, 0, 0,
+                               m_id, GL_TEXTURE_2D_ARRAY, i, 0, 0, layer,
+                               level.width, level.height, 1);
+        }
+        glDeleteTextures(1, &stagingId);
+    });
+}
+
+void Texture2DArray::use()
+{
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_id);
+}
+
+//
+// Cubemap
+//
+
+TextureCubeMap::TextureCubeMap()
+: m_id(0), m_streamingId(0), m_nFacesStreamed(0)
+{
+
+}
+
+GLuint TextureCubeMap::create()
+{
+    GLuint id;
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, id);
 
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    return id;
+}
+
+void TextureCubeMap::uploadFace(unsigned int face, const ImageData& image)
+{
+    glBindTexture(GL_TEXTURE_CUBE_MAP, m_id);
+    uploadImage(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, image);
+}
+
+void TextureCubeMap::load(const char** pathes)
+{
+    m_id = create();
+    for (unsigned int i = 0; i < 6; i++)
+    {
+        uploadFace(i, *decodeImage(pathes[i], false));
+    }
+}
 
+void TextureCubeMap::load(const char** pathes, AssetLoader& loader)
+{
+    m_id = create();
     for (unsigned int i = 0; i < 6; i++)
     {
-        GLenum format = getFormat(nChannels[i]);
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, format,
-                     widths[i], heights[i], 0, format, GL_UNSIGNED_BYTE, datas[i]);
+        std::string pathStr = pathes[i];
+        loader.enqueue(pathStr, [this, i, pathStr]() -> AssetLoader::UploadFunction
+        {
+            std::shared_ptr<ImageData> image = decodeImage(pathStr.c_str(), false);
+            return [this, i, image]() { uploadFace(i, *image); };
+        });
+    }
+}
+
+void TextureCubeMap::load(const char** pathes, AssetLoader& loader, TextureStreamer& streamer)
+{
+    if (!m_id)
+    {
+        m_id = create();
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (unsigned int i = 0; i < 6; i++)
+        {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_PIXEL);
+        }
     }
 
+    GLuint streamingId = create();
+    m_streamingId = streamingId;
+    m_nFacesStreamed = 0;
     for (unsigned int i = 0; i < 6; i++)
     {
-        stbi_image_free(datas[i]);
+        std::string pathStr = pathes[i];
+        loader.enqueue(pathStr, [this, i, pathStr, streamingId, &streamer]() -> AssetLoader::UploadFunction
+        {
+            std::shared_ptr<ImageData> image = decodeImage(pathStr.c_str(), false);
+            return [this, i, image, streamingId, &streamer]()
+            {
+                streamer.enqueue(streamingId, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, image, [this, streamingId]()
+                {
+                    if (++m_nFacesStreamed < 6)
+                        return;
+                    glDeleteTextures(1, &m_id);
+                    m_id = streamingId;
+                    m_streamingId = 0;
+                });
+            };
+        });
     }
 }
 
 TextureCubeMap::~TextureCubeMap()
 {
     glDeleteTextures(1, &m_id);
+    if (m_streamingId)
+        glDeleteTextures(1, &m_streamingId);
 }
 
 void TextureCubeMap::use()
@@ -1,10 +1,45 @@
 #ifndef TEXTURES_H
 #define TEXTURES_H
 
+#include <memory>
+#include <vector>
+
 #include <glbinding/gl/gl.h>
 
 using namespace gl;
 
+class AssetLoader;
+class TextureStreamer;
+
+struct ImageLevel
+{
+	int width;
+	int height;
+	size_t offset;
+	size_t size;
+};
+
+struct ImageData
+{
+	int width;
+	int height;
+	int nChannels;
+	GLenum compressedFormat; // GL_NONE si l'image n'est pas compressée
+	std::vector<ImageLevel> levels;
+	std::vector<unsigned char> pixels;
+};
+
+GLenum getFormat(int nChannels);
+
+// Une rangée est une ligne de pixels, ou une ligne de blocs 4x4 si l'image est compressée.
+size_t getRowSize(const ImageData& image, const ImageLevel& level);
+int getRowCount(const ImageData& image, const ImageLevel& level);
+
+// Utilise le fichier .dds voisin s'il existe et est à jour. Il doit alors déjà
+// avoir été retourné par l'outil de compression, flipVertically est ignoré.
+
+std::shared_ptr<ImageData> decodeImage(const char* path, bool flipVertically);
+
 class Texture2D
 {
 public:
@@ -12,16 +47,65 @@ public:
 	~Texture2D();
 	
 	void load(const char* path);
+	void load(const char* path, AssetLoader& loader);
+	// Affiche une texture temporaire jusqu'à la fin du téléversement par le streamer.
+	void load(const char* path, AssetLoader& loader, TextureStreamer& streamer);
 	
+	// Avec les mipmaps activés, le filtre de minification utilise aussi les niveaux.
 	void setFiltering(GLenum filteringMode);
 	void setWrap(GLenum wrapMode);
+	void setLodBias(float bias);
 
 	void enableMipmap();
 
 	void use();
 
+private:
+	void upload(const ImageData& image);
+	void applyParameters();
+	GLenum getMinFilter() const;
+
 private:
 	GLuint m_id;
+	GLuint m_streamingId;
+	unsigned int m_nLevels;
+	bool m_isUploaded;
+	bool m_isMipmapEnabled;
+	GLenum m_minFilter;
+	GLenum m_magFilter;
+	GLenum m_wrap;
+	float m_lodBias;
+};
+
+
+// Tableau de textures carrées de même taille et de même format, avec leurs mipmaps.
+// Chaque couche est lue dans le .dds produit hors ligne par TextureCompressor
+// (--size), qui doit avoir cette taille, ce format et toute la chaîne de niveaux.
+class Texture2DArray
+{
+public:
+	Texture2DArray();
+	~Texture2DArray();
+
+	// Les couches sont grises jusqu'à leur téléversement.
+	void allocate(int size, int nLayers, GLenum internalFormat);
+	void loadLayer(int layer, const char* path, AssetLoader& loader);
+	// Téléverse la couche par bandes à travers le streamer, dans une texture
+	// intermédiaire copiée d'un coup dans la couche une fois complète.
+	void loadLayer(int layer, const char* path, AssetLoader& loader, TextureStreamer& streamer);
+
+	void use();
+
+private:
+	bool isLayerImageValid(const char* path, const ImageData& image) const;
+	void uploadLayer(int layer, const ImageData& image);
+	void streamLayer(int layer, std::shared_ptr<ImageData> image, TextureStreamer& streamer);
+
+private:
+	GLuint m_id;
+	int m_size;
+	int m_nLevels;
+	GLenum m_internalFormat;
 };
 
 
@@ -32,11 +116,19 @@ public:
 	~TextureCubeMap();
 	
 	void load(const char** path);
+	void load(const char** path, AssetLoader& loader);
+	void load(const char** path, AssetLoader& loader, TextureStreamer& streamer);
 
 	void use();
 
+private:
+	static GLuint create();
+	void uploadFace(unsigned int face, const ImageData& image);
+
 private:
 	GLuint m_id;
+	GLuint m_streamingId;
+	unsigned int m_nFacesStreamed;
 };
 
 
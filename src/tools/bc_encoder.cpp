@@ -0,0 +1,216 @@
+#include "bc_encoder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+static uint16_t packRgb565(const float color[3])
+{
+    int r = std::clamp((int)std::lround(color[0] * 31.0f / 255.0f), 0, 31);
+    int g = std::clamp((int)std::lround(color[1] * 63.0f / 255.0f), 0, 63);
+    int b = std::clamp((int)std::lround(color[2] * 31.0f / 255.0f), 0, 31);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void unpackRgb565(uint16_t packed, int color[3])
+{
+    int r = (packed >> 11) & 31;
+    int g = (packed >> 5) & 63;
+    int b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// Trouve les extrémités du nuage de couleurs le long de son axe principal.
+static void findColorEndpoints(const unsigned char* rgba, float minColor[3], float maxColor[3])
+{
+    float mean[3] = {0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 3; c++)
+            mean[c] += rgba[i * 4 + c] / 16.0f;
+
+    float cov[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < 16; i++)
+    {
+        float r = rgba[i * 4 + 0] - mean[0];
+        float g = rgba[i * 4 + 1] - mean[1];
+        float b = rgba[i * 4 + 2] - mean[2];
+        cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+        cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+    }
+
+    // Itération de la puissance pour le vecteur propre dominant.
+    float axis[3] = {1.0f, 1.0f, 1.0f};
+    for (int iteration = 0; iteration < 8; iteration++)
+    {
+        float next[3] = {
+            cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+            cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+            cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2],
+        };
+        float length = std::max({std::fabs(next[0]), std::fabs(next[1]), std::fabs(next[2])});
+        if (length < 1e-6f)
+            break;
+        for (int c = 0; c < 3; c++)
+            axis[c] = next[c] / length;
+    }
+
+    float minProj = 1e30f, maxProj = -1e30f;
+    for (int i = 0; i < 16; i++)
+    {
+        float proj = 0.0f;
+        for (int c = 0; c < 3; c++)
+            proj += (rgba[i * 4 + c] - mean[c]) * axis[c];
+        minProj = std::min(minProj, proj);
+        maxProj = std::max(maxProj, proj);
+    }
+
+    float axisLength2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    // Rentre les extrémités d'un seizième pour mieux couvrir les couleurs intermédiaires.
+    float inset = (maxProj - minProj) / 16.0f;
+    for (int c = 0; c < 3; c++)
+    {
+        minColor[c] = std::clamp(mean[c] + axis[c] * (minProj + inset) / axisLength2, 0.0f, 255.0f);
+        maxColor[c] = std::clamp(mean[c] + axis[c] * (maxProj - inset) / axisLength2, 0.0f, 255.0f);
+    }
+}
+
+// Bloc de couleur en mode 4 couleurs (color0 > color1), partagé par BC1 et BC3.
+static void encodeColorBlock(const unsigned char* rgba, unsigned char* out)
+{
+    float minColor[3], maxColor[3];
+    findColorEndpoints(rgba, minColor, maxColor);
+
+    uint16_t color0 = packRgb565(maxColor);
+    uint16_t color1 = packRgb565(minColor);
+    if (color0 < color1)
+        std::swap(color0, color1);
+
+    uint32_t indices = 0;
+    if (color0 != color1)
+    {
+        int palette[4][3];
+        unpackRgb565(color0, palette[0]);
+        unpackRgb565(color1, palette[1]);
+        for (int c = 0; c < 3; c++)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        for (int i = 0; i < 16; i++)
+        {
+            int bestIndex = 0;
+            int bestDistance = 1 << 30;
+            for (int j = 0; j < 4; j++)
+            {
+                int distance = 0;
+                for (int c = 0; c < 3; c++)
+                {
+                    int d = rgba[i * 4 + c] - palette[j][c];
+                    distance += d * d;
+                }
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    bestIndex = j;
+                }
+            }
+            indices |= (uint32_t)bestIndex << (2 * i);
+        }
+    }
+
+    out[0] = color0 & 0xFF;
+    out[1] = color0 >> 8;
+    out[2] = color1 & 0xFF;
+    out[3] = color1 >> 8;
+    for (int i = 0; i < 4; i++)
+        out[4 + i] = (indices >> (8 * i)) & 0xFF;
+}
+
+// Bloc alpha BC3 en mode 8 valeurs (alpha0 > alpha1).
+static void encodeAlphaBlock(const unsigned char* rgba, unsigned char* out)
+{
+    int alpha0 = 0, alpha1 = 255;
+    for (int i = 0; i < 16; i++)
+    {
+        alpha0 = std::max<int>(alpha0, rgba[i * 4 + 3]);
+        alpha1 = std::min<int>(alpha1, rgba[i * 4 + 3]);
+    }
+
+    uint64_t indices = 0;
+    if (alpha0 != alpha1)
+    {
+        int palette[8] = {alpha0, alpha1};
+        for (int j = 1; j < 7; j++)
+            palette[j + 1] = ((7 - j) * alpha0 + j * alpha1) / 7;
+
+        for (int i = 0; i < 16; i++)
+        {
+            int bestIndex = 0;
+            int bestDistance = 256;
+            for (int j = 0; j < 8; j++)
+            {
+                int distance = std::abs(rgba[i * 4 + 3] - palette[j]);
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    bestIndex = j;
+                }
+            }
+            indices |= (uint64_t)bestIndex << (3 * i);
+        }
+    }
+
+    out[0] = alpha0;
+    out[1] = alpha1;
+    for (int i = 0; i < 6; i++)
+        out[2 + i] = (indices >> (8 * i)) & 0xFF;
+}
+
+void encodeBlockBC1(const unsigned char* rgba, unsigned char* out)
+{
+    encodeColorBlock(rgba, out);
+}
+
+void encodeBlockBC3(const unsigned char* rgba, unsigned char* out)
+{
+    encodeAlphaBlock(rgba, out);
+    encodeColorBlock(rgba, out + 8);
+}
+
+void compressImage(const unsigned char* rgba, int width, int height, DdsFormat format, unsigned char* out)
+{
+    if (format == DdsFormat::BC7)
+    {
+        std::cout << "BC7 encoding is not supported" << std::endl;
+        return;
+    }
+
+    size_t blockSize = getDdsBlockSize(format);
+    unsigned char block[64];
+    for (int by = 0; by < height; by += 4)
+    {
+        for (int bx = 0; bx < width; bx += 4)
+        {
+            for (int y = 0; y < 4; y++)
+            {
+                int srcY = std::min(by + y, height - 1);
+                for (int x = 0; x < 4; x++)
+                {
+                    int srcX = std::min(bx + x, width - 1);
+                    std::memcpy(&block[(y * 4 + x) * 4], &rgba[((size_t)srcY * width + srcX) * 4], 4);
+                }
+            }
+
+            if (format == DdsFormat::BC1)
+                encodeBlockBC1(block, out);
+            else
+                encodeBlockBC3(block, out);
+            out += blockSize;
+        }
+    }
+}
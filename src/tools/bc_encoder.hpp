@@ -0,0 +1,17 @@
+#ifndef BC_ENCODER_H
+#define BC_ENCODER_H
+
+#include "../dds.hpp"
+
+// Encodeur BC1/BC3 simple (axe principal + ajustement des extrémités).
+// Suffisant pour des textures de scène, sans viser la qualité des encodeurs dédiés.
+
+// Encode un bloc de 4x4 pixels RGBA (64 octets).
+void encodeBlockBC1(const unsigned char* rgba, unsigned char* out);
+void encodeBlockBC3(const unsigned char* rgba, unsigned char* out);
+
+// Encode une image RGBA complète. Les blocs qui dépassent le bord répètent les derniers pixels.
+// out doit contenir getDdsLevelSize(format, width, height) octets.
+void compressImage(const unsigned char* rgba, int width, int height, DdsFormat format, unsigned char* out);
+
+#endif // BC_ENCODER_H
@@ -0,0 +1,153 @@
+#include "mipmap.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+static float srgbToLinear(float value)
+{
+    return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+static float linearToSrgb(float value)
+{
+    return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+static void buildLinearTable(float* toLinear, bool isSrgb)
+{
+    for (int i = 0; i < 256; i++)
+        toLinear[i] = isSrgb ? srgbToLinear(i / 255.0f) : i / 255.0f;
+}
+
+static unsigned char encodeChannel(float value, bool isSrgb)
+{
+    if (!isSrgb)
+        return (unsigned char)std::clamp((int)std::lround(value * 255.0f), 0, 255);
+
+    // Table assez fine pour que l'erreur reste sous un demi-pas de 8 bits près du noir.
+    static const int TABLE_SIZE = 4096;
+    static const std::vector<unsigned char> toSrgb = []()
+    {
+        std::vector<unsigned char> table(TABLE_SIZE + 1);
+        for (int i = 0; i <= TABLE_SIZE; i++)
+            table[i] = (unsigned char)std::lround(linearToSrgb((float)i / TABLE_SIZE) * 255.0f);
+        return table;
+    }();
+    return toSrgb[std::clamp((int)(value * TABLE_SIZE + 0.5f), 0, TABLE_SIZE)];
+}
+
+static MipLevel downsample(const MipLevel& level, const float* toLinear, bool isSrgb)
+{
+    MipLevel result;
+    result.width = std::max(1, level.width / 2);
+    result.height = std::max(1, level.height / 2);
+    result.rgba.resize((size_t)result.width * result.height * 4);
+
+    for (int y = 0; y < result.height; y++)
+    {
+        int srcYs[2] = {std::min(2 * y, level.height - 1), std::min(2 * y + 1, level.height - 1)};
+        for (int x = 0; x < result.width; x++)
+        {
+            int srcXs[2] = {std::min(2 * x, level.width - 1), std::min(2 * x + 1, level.width - 1)};
+
+            float color[3] = {0.0f, 0.0f, 0.0f};
+            float weightedColor[3] = {0.0f, 0.0f, 0.0f};
+            float alpha = 0.0f;
+            for (int srcY : srcYs)
+            {
+                for (int srcX : srcXs)
+                {
+                    const unsigned char* texel = &level.rgba[((size_t)srcY * level.width + srcX) * 4];
+                    float texelAlpha = texel[3] / 255.0f;
+                    for (int c = 0; c < 3; c++)
+                    {
+                        color[c] += toLinear[texel[c]];
+                        weightedColor[c] += toLinear[texel[c]] * texelAlpha;
+                    }
+                    alpha += texelAlpha;
+                }
+            }
+
+            unsigned char* out = &result.rgba[((size_t)y * result.width + x) * 4];
+            for (int c = 0; c < 3; c++)
+            {
+                float value = alpha > 0.0f ? weightedColor[c] / alpha : color[c] / 4.0f;
+                out[c] = encodeChannel(value, isSrgb);
+            }
+            out[3] = (unsigned char)std::lround(alpha / 4.0f * 255.0f);
+        }
+    }
+    return result;
+}
+
+std::vector<MipLevel> buildMipChain(std::vector<unsigned char> rgba, int width, int height, bool isSrgb)
+{
+    float toLinear[256];
+    buildLinearTable(toLinear, isSrgb);
+
+    std::vector<MipLevel> levels;
+    levels.push_back({width, height, std::move(rgba)});
+    while (levels.back().width > 1 || levels.back().height > 1)
+        levels.push_back(downsample(levels.back(), toLinear, isSrgb));
+    return levels;
+}
+
+MipLevel resizeImage(const MipLevel& level, int width, int height, bool isNearest, bool isSrgb)
+{
+    MipLevel result;
+    result.width = width;
+    result.height = height;
+    result.rgba.resize((size_t)width * height * 4);
+
+    float toLinear[256];
+    buildLinearTable(toLinear, isSrgb);
+
+    float scaleX = (float)level.width / width;
+    float scaleY = (float)level.height / height;
+    for (int y = 0; y < height; y++)
+    {
+        // Centre du texel de destination dans l'image source.
+        float srcY = (y + 0.5f) * scaleY - 0.5f;
+        int y0 = std::clamp((int)std::floor(srcY), 0, level.height - 1);
+        int y1 = std::min(y0 + 1, level.height - 1);
+        float fy = std::clamp(srcY - y0, 0.0f, 1.0f);
+        for (int x = 0; x < width; x++)
+        {
+            float srcX = (x + 0.5f) * scaleX - 0.5f;
+            int x0 = std::clamp((int)std::floor(srcX), 0, level.width - 1);
+            int x1 = std::min(x0 + 1, level.width - 1);
+            float fx = std::clamp(srcX - x0, 0.0f, 1.0f);
+
+            unsigned char* out = &result.rgba[((size_t)y * width + x) * 4];
+            if (isNearest)
+            {
+                int nearestX = std::min((int)((x + 0.5f) * scaleX), level.width - 1);
+                int nearestY = std::min((int)((y + 0.5f) * scaleY), level.height - 1);
+                const unsigned char* texel = &level.rgba[((size_t)nearestY * level.width + nearestX) * 4];
+                std::copy(texel, texel + 4, out);
+                continue;
+            }
+
+            const unsigned char* texels[4] = {
+                &level.rgba[((size_t)y0 * level.width + x0) * 4],
+                &level.rgba[((size_t)y0 * level.width + x1) * 4],
+                &level.rgba[((size_t)y1 * level.width + x0) * 4],
+                &level.rgba[((size_t)y1 * level.width + x1) * 4],
+            };
+            float weights[4] = {(1 - fx) * (1 - fy), fx * (1 - fy), (1 - fx) * fy, fx * fy};
+            for (int c = 0; c < 3; c++)
+            {
+                float value = 0.0f;
+                for (int i = 0; i < 4; i++)
+                    value += toLinear[texels[i][c]] * weights[i];
+                out[c] = encodeChannel(value, isSrgb);
+            }
+            float alpha = 0.0f;
+            for (int i = 0; i < 4; i++)
+                alpha += texels[i][3] * weights[i];
+            out[3] = (unsigned char)std::lround(alpha);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,23 @@
+#ifndef MIPMAP_H
+#define MIPMAP_H
+
+#include <vector>
+
+struct MipLevel
+{
+    int width;
+    int height;
+    std::vector<unsigned char> rgba;
+};
+
+// Redimensionne une image RGBA. Le filtre bilinéaire est appliqué en espace linéaire
+// si isSrgb; isNearest garde les texels nets des petites textures agrandies.
+MipLevel resizeImage(const MipLevel& level, int width, int height, bool isNearest, bool isSrgb);
+
+// Construit toute la chaîne de mipmaps d'une image RGBA, jusqu'à 1x1. Le premier
+// niveau est l'image elle-même. Si isSrgb, la moyenne est faite en espace linéaire
+// pour ne pas assombrir les niveaux réduits. La couleur est pondérée par l'alpha
+// pour éviter les franges sombres autour des zones transparentes.
+std::vector<MipLevel> buildMipChain(std::vector<unsigned char> rgba, int width, int height, bool isSrgb);
+
+#endif // MIPMAP_H
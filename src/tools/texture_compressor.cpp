@@ -0,0 +1,135 @@
+// Convertit les images de textures/ en fichiers .dds avec toute la chaîne de
+// mipmaps, filtrée en espace linéaire. Le fichier est écrit à côté de l'image
+// source et est préféré par le chargeur de textures lorsqu'il est à jour.
+//
+// Usage: TextureCompressor [--flip] [--linear] [--bc1 | --bc3 | --rgba8] [--size N [--nearest]] image...
+//   --flip    retourne l'image verticalement (textures 2D, pas les faces de skybox)
+//   --linear  l'image ne contient pas des couleurs sRGB (normales, masques, ...)
+//   --bc1     force BC1, --bc3 force BC3, --rgba8 garde les niveaux non compressés;
+//             sinon BC3 seulement si l'image a de l'alpha
+//   --size    redimensionne en NxN, pour une couche de tableau de textures
+//   --nearest agrandit sans filtrer, pour garder les texels nets des petites images
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../stb_image.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../dds.hpp"
+#include "bc_encoder.hpp"
+#include "mipmap.hpp"
+
+static bool hasAlpha(const std::vector<unsigned char>& rgba)
+{
+    for (size_t i = 3; i < rgba.size(); i += 4)
+    {
+        if (rgba[i] != 255)
+            return true;
+    }
+    return false;
+}
+
+static bool compressFile(const char* path, bool flipVertically, bool isSrgb, int forcedFormat, int size, bool isNearest)
+{
+    int width, height, nChannels;
+    unsigned char* data = stbi_load(path, &width, &height, &nChannels, 4);
+    if (data == NULL)
+    {
+        std::cout << "Error loading \"" << path << "\": " << stbi_failure_reason() << std::endl;
+        return false;
+    }
+
+    size_t rowSize = (size_t)width * 4;
+    std::vector<unsigned char> rgba(rowSize * height);
+    for (int y = 0; y < height; y++)
+    {
+        int srcY = flipVertically ? height - 1 - y : y;
+        std::memcpy(&rgba[y * rowSize], data + srcY * rowSize, rowSize);
+    }
+    stbi_image_free(data);
+
+    if (size > 0 && (width != size || height != size))
+    {
+        MipLevel resized = resizeImage({width, height, std::move(rgba)}, size, size, isNearest, isSrgb);
+        width = height = size;
+        rgba = std::move(resized.rgba);
+    }
+
+    DdsImage image;
+    if (forcedFormat >= 0)
+        image.format = (DdsFormat)forcedFormat;
+    else
+        image.format = hasAlpha(rgba) ? DdsFormat::BC3 : DdsFormat::BC1;
+    image.width = width;
+    image.height = height;
+
+    for (const MipLevel& level : buildMipChain(std::move(rgba), width, height, isSrgb))
+    {
+        size_t levelSize = getDdsLevelSize(image.format, level.width, level.height);
+        size_t offset = image.data.size();
+        image.levels.push_back({(uint32_t)level.width, (uint32_t)level.height, offset, levelSize});
+        image.data.resize(offset + levelSize);
+        if (image.format == DdsFormat::RGBA8)
+            std::memcpy(&image.data[offset], level.rgba.data(), levelSize);
+        else
+            compressImage(level.rgba.data(), level.width, level.height, image.format, &image.data[offset]);
+    }
+
+    std::string outputPath = std::filesystem::path(path).replace_extension(".dds").string();
+    if (!writeDds(outputPath.c_str(), image))
+        return false;
+
+    size_t originalSize = (size_t)image.width * image.height * nChannels;
+    const char* formatNames[] = {"BC1", "BC3", "BC7", "RGBA8"};
+    std::cout << path << " -> " << outputPath << " ("
+              << formatNames[(int)image.format] << ", "
+              << image.levels.size() << " levels, "
+              << originalSize / 1024 << " KB -> " << image.data.size() / 1024 << " KB)" << std::endl;
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    bool flipVertically = false;
+    bool isSrgb = true;
+    int forcedFormat = -1;
+    int size = 0;
+    bool isNearest = false;
+    std::vector<const char*> paths;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--flip") == 0)
+            flipVertically = true;
+        else if (std::strcmp(argv[i], "--linear") == 0)
+            isSrgb = false;
+        else if (std::strcmp(argv[i], "--bc1") == 0)
+            forcedFormat = (int)DdsFormat::BC1;
+        else if (std::strcmp(argv[i], "--bc3") == 0)
+            forcedFormat = (int)DdsFormat::BC3;
+        else if (std::strcmp(argv[i], "--rgba8") == 0)
+            forcedFormat = (int)DdsFormat::RGBA8;
+        else if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+            size = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--nearest") == 0)
+            isNearest = true;
+        else
+            paths.push_back(argv[i]);
+    }
+
+    if (paths.empty())
+    {
+        std::cout << "Usage: " << argv[0] << " [--flip] [--linear] [--bc1 | --bc3 | --rgba8] [--size N [--nearest]] image..." << std::endl;
+        return 1;
+    }
+
+    bool isSuccess = true;
+    for (const char* path : paths)
+        isSuccess = compressFile(path, flipVertically, isSrgb, forcedFormat, size, isNearest) && isSuccess;
+    return isSuccess ? 0 : 1;
+}
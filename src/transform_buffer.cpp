@@ -0,0 +1,70 @@
+#include "transform_buffer.hpp"
+
+#include <algorithm>
+
+TransformBuffer::TransformBuffer()
+: nStaticInstances_(0), maxInstances_(0)
+{
+}
+
+InstanceRange TransformBuffer::addStatic(const glm::mat4* models, GLsizei count, GLuint materialIndex)
+{
+    InstanceRange range = {(GLuint)instances_.size(), count};
+    for (GLsizei i = 0; i < count; i++)
+        instances_.push_back({models[i], materialIndex});
+    return range;
+}
+
+void TransformBuffer::allocate(GLuint maxDynamicInstances)
+{
+    nStaticInstances_ = instances_.size();
+    maxInstances_ = nStaticInstances_ + maxDynamicInstances;
+
+    buffer_.allocate(nullptr, maxInstances_ * sizeof(InstanceData), GL_DYNAMIC_DRAW);
+    buffer_.updateData(instances_.data(), 0, instances_.size() * sizeof(InstanceData));
+}
+
+void TransformBuffer::setBindingIndex(GLuint index)
+{
+    buffer_.setBindingIndex(index);
+}
+
+const glm::mat4& TransformBuffer::getModel(GLuint index) const
+{
+    return instances_[index].model;
+}
+
+void TransformBuffer::beginFrame()
+{
+    instances_.resize(nStaticInstances_);
+}
+
+GLuint TransformBuffer::push(const glm::mat4& model, GLuint materialIndex)
+{
+    instances_.push_back({model, materialIndex});
+    return instances_.size() - 1;
+}
+
+void TransformBuffer::upload(GeometryPool& pool)
+{
+    bool isGrowing = instances_.size() > maxInstances_;
+    if (isGrowing)
+        maxInstances_ = std::max<GLuint>(instances_.size(), maxInstances_ * 2);
+    // Chaque indice du tampon doit aussi exister comme attribut d'instance.
+    pool.reserveInstances(maxInstances_);
+
+    if (isGrowing)
+    {
+        // Le tampon est réalloué en entier, la zone statique est donc réécrite aussi.
+        buffer_.allocate(nullptr, maxInstances_ * sizeof(InstanceData), GL_DYNAMIC_DRAW);
+        buffer_.updateData(instances_.data(), 0, instances_.size() * sizeof(InstanceData));
+        return;
+    }
+
+    GLsizeiptr nDynamicInstances = instances_.size() - nStaticInstances_;
+    if (nDynamicInstances > 0)
+    {
+        buffer_.updateData(&instances_[nStaticInstances_], nStaticInstances_ * sizeof(InstanceData),
+                           nDynamicInstances * sizeof(InstanceData));
+    }
+}
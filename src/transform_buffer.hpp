@@ -0,0 +1,46 @@
+#ifndef TRANSFORM_BUFFER_H
+#define TRANSFORM_BUFFER_H
+
+#include <vector>
+
+#include <glbinding/gl/gl.h>
+#include <glm/glm.hpp>
+
+#include "geometry_pool.hpp"
+#include "model.hpp"
+#include "shader_storage_buffer.hpp"
+
+using namespace gl;
+
+// Tampon InstanceBlock des nuanceurs: les transformations statiques sont écrites
+// une seule fois au début, suivies d'une zone réécrite à chaque image pour les
+// objets qui bougent. Chaque objet y écrit sa matrice modèle une fois par image.
+// La zone dynamique grandit au besoin, avec les indices d'instances de
+// GeometryPool: chaque indice retourné par push est valide.
+class TransformBuffer
+{
+public:
+    TransformBuffer();
+
+    // Avant allocate() seulement.
+    InstanceRange addStatic(const glm::mat4* models, GLsizei count, GLuint materialIndex);
+    // Capacité initiale de la zone dynamique.
+    void allocate(GLuint maxDynamicInstances);
+
+    void setBindingIndex(GLuint index);
+
+    const glm::mat4& getModel(GLuint index) const;
+
+    void beginFrame();
+    // Retourne l'indice à passer comme baseInstance.
+    GLuint push(const glm::mat4& model, GLuint materialIndex = 0);
+    void upload(GeometryPool& pool);
+
+private:
+    ShaderStorageBuffer buffer_;
+    std::vector<InstanceData> instances_;
+    GLuint nStaticInstances_;
+    GLuint maxInstances_;
+};
+
+#endif // TRANSFORM_BUFFER_H
@@ -0,0 +1,121 @@
+#include "transparency_pass.hpp"
+
+#include <iostream>
+
+// Unités des samplers de transparencyComposite.fs.
+static const GLuint ACCUMULATION_TEXTURE_UNIT = 4;
+static const GLuint REVEALAGE_TEXTURE_UNIT = 5;
+
+TransparencyPass::TransparencyPass()
+: framebuffer_(0), accumulationTexture_(0), revealageTexture_(0), depthTexture_(0)
+, vao_(0), width_(0), height_(0)
+{
+}
+
+TransparencyPass::~TransparencyPass()
+{
+    glDeleteFramebuffers(1, &framebuffer_);
+    glDeleteTextures(1, &accumulationTexture_);
+    glDeleteTextures(1, &revealageTexture_);
+    glDeleteVertexArrays(1, &vao_);
+}
+
+void TransparencyPass::init()
+{
+    shader_.create();
+    glGenFramebuffers(1, &framebuffer_);
+    glGenVertexArrays(1, &vao_);
+}
+
+void TransparencyPass::reloadShader()
+{
+    shader_.create();
+}
+
+void TransparencyPass::begin(GLuint opaqueDepthTexture, GLsizei width, GLsizei height)
+{
+    if (width != width_ || height != height_)
+        allocateTextures(width, height);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    if (opaqueDepthTexture != depthTexture_)
+    {
+        depthTexture_ = opaqueDepthTexture;
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, depthTexture_, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "Transparency framebuffer incomplete" << std::endl;
+    }
+
+    const GLfloat ZERO[] = {0.0f, 0.0f, 0.0f, 0.0f};
+    const GLfloat ONE[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    glClearBufferfv(GL_COLOR, 0, ZERO);
+    glClearBufferfv(GL_COLOR, 1, ONE);
+
+    resume();
+}
+
+void TransparencyPass::resume()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glViewport(0, 0, width_, height_);
+    glDepthMask(GL_FALSE);
+    glEnable(GL_BLEND);
+    glBlendFunci(0, GL_ONE, GL_ONE);
+    glBlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+}
+
+void TransparencyPass::resolve()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glActiveTexture(GL_TEXTURE0 + ACCUMULATION_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, accumulationTexture_);
+    glActiveTexture(GL_TEXTURE0 + REVEALAGE_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, revealageTexture_);
+    glActiveTexture(GL_TEXTURE0);
+
+    shader_.use();
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDisable(GL_DEPTH_TEST);
+    glBindVertexArray(vao_);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+    glEnable(GL_DEPTH_TEST);
+
+    glDisable(GL_BLEND);
+    glDepthMask(GL_TRUE);
+}
+
+void TransparencyPass::allocateTextures(GLsizei width, GLsizei height)
+{
+    width_ = width;
+    height_ = height;
+    // La texture de profondeur opaque a aussi été recréée: à rattacher.
+    depthTexture_ = 0;
+
+    glDeleteTextures(1, &accumulationTexture_);
+    glDeleteTextures(1, &revealageTexture_);
+    GLuint textures[2];
+    glGenTextures(2, textures);
+    accumulationTexture_ = textures[0];
+    revealageTexture_ = textures[1];
+
+    // Les sommes pondérées dépassent 1: il faut des flottants.
+    glBindTexture(GL_TEXTURE_2D, accumulationTexture_);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glBindTexture(GL_TEXTURE_2D, revealageTexture_);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_R8, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, accumulationTexture_, 0);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, revealageTexture_, 0);
+    const GLenum DRAW_BUFFERS[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, DRAW_BUFFERS);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
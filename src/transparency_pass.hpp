@@ -0,0 +1,45 @@
+#ifndef TRANSPARENCY_PASS_H
+#define TRANSPARENCY_PASS_H
+
+#include <glbinding/gl/gl.h>
+
+#include "shaders.hpp"
+
+using namespace gl;
+
+// Transparence indépendante de l'ordre (weighted blended OIT, McGuire et
+// Bavoil 2013). Les surfaces transparentes s'accumulent, pondérées par leur
+// profondeur, dans deux cibles: somme des couleurs prémultipliées et produit
+// des (1 - alpha). Une passe plein écran les compose ensuite sur la scène;
+// aucun tri n'est nécessaire.
+class TransparencyPass
+{
+public:
+    TransparencyPass();
+    ~TransparencyPass();
+
+    void init();
+    void reloadShader();
+
+    // Les surfaces sont testées contre la profondeur de la scène opaque, sans
+    // l'écrire. Les nuanceurs liés ensuite doivent écrire les deux sorties OIT.
+    void begin(GLuint opaqueDepthTexture, GLsizei width, GLsizei height);
+    // Relie les cibles sans les effacer, après une passe qui en a changé.
+    void resume();
+    // Compose le résultat sur le tampon par défaut et rétablit les états.
+    void resolve();
+
+private:
+    void allocateTextures(GLsizei width, GLsizei height);
+
+private:
+    TransparencyComposite shader_;
+    GLuint framebuffer_;
+    GLuint accumulationTexture_;
+    GLuint revealageTexture_;
+    GLuint depthTexture_;
+    GLuint vao_;
+    GLsizei width_, height_;
+};
+
+#endif // TRANSPARENCY_PASS_H
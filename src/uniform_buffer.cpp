@@ -1,29 +1,144 @@
 #include "uniform_buffer.hpp"
 
+#include <cstring>
+#include <iostream>
+
 UniformBuffer::UniformBuffer()
+: id_(0), byteSize_(0), bindingIndex_(0)
+, isRing_(false), mappedData_(nullptr), slotSize_(0), slotsPerFrame_(0)
+, currentFrame_(0), currentSlot_(0)
 {
 }
 
 UniformBuffer::~UniformBuffer()
 {
+    for (GLsync fence : fences_)
+    {
+        if (fence)
+            glDeleteSync(fence);
+    }
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    if (mappedData_)
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, id_);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
     glDeleteBuffers(1, &id_);
 }
 
 void UniformBuffer::allocate(const void* data, GLsizeiptr byteSize)
 {
+    byteSize_ = byteSize;
     glGenBuffers(1, &id_);
     glBindBuffer(GL_UNIFORM_BUFFER, id_);
     glBufferData(GL_UNIFORM_BUFFER, byteSize, data, GL_DYNAMIC_DRAW);
 }
 
+void UniformBuffer::allocateRing(const void* data, GLsizeiptr byteSize, unsigned int maxUpdatesPerFrame, unsigned int nFrames)
+{
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+    isRing_ = true;
+    byteSize_ = byteSize;
+    slotSize_ = (byteSize + alignment - 1) / alignment * alignment;
+    slotsPerFrame_ = maxUpdatesPerFrame;
+    fences_.assign(nFrames, nullptr);
+    shadow_.assign((const unsigned char*)data, (const unsigned char*)data + byteSize);
+
+    GLsizeiptr totalSize = slotSize_ * slotsPerFrame_ * nFrames;
+    glGenBuffers(1, &id_);
+    glBindBuffer(GL_UNIFORM_BUFFER, id_);
+    glBufferStorage(GL_UNIFORM_BUFFER, totalSize, nullptr,
+                    GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+    mappedData_ = (unsigned char*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, totalSize,
+                                                   GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+
+    currentFrame_ = 0;
+    currentSlot_ = 0;
+    writeRingSlot();
+}
+
 void UniformBuffer::setBindingIndex(GLuint index)
 {
-    glBindBufferBase(GL_UNIFORM_BUFFER, index, id_);
+    bindingIndex_ = index;
+    if (isRing_)
+        bindRingSlot();
+    else
+        glBindBufferBase(GL_UNIFORM_BUFFER, index, id_);
 }
 
 void UniformBuffer::updateData(const void* data, GLintptr offset, GLsizeiptr byteSize)
 {
+    if (isRing_)
+    {
+        // Le bloc entier est recopié: les parties non modifiées viennent de la copie locale.
+        std::memcpy(&shadow_[offset], data, byteSize);
+        currentSlot_++;
+        if (currentSlot_ >= slotsPerFrame_)
+        {
+            // Les copies de cette région servent encore aux dessins de l'image: on passe
+            // à la région suivante, quitte à attendre le GPU, plutôt que d'en écraser une.
+            std::cout << "Uniform buffer ring full, increase maxUpdatesPerFrame (" << slotsPerFrame_ << ")" << std::endl;
+            fences_[currentFrame_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, GL_NONE_BIT);
+            advanceRegion();
+        }
+        writeRingSlot();
+        bindRingSlot();
+        return;
+    }
+
     glBindBuffer(GL_UNIFORM_BUFFER, id_);
     glBufferSubData(GL_UNIFORM_BUFFER, offset, byteSize, data);
 }
+
+void UniformBuffer::beginFrame()
+{
+    if (!isRing_)
+        return;
+
+    advanceRegion();
+
+    // La copie liée est dans une région qui sera bientôt réutilisée: on la reporte ici.
+    writeRingSlot();
+    bindRingSlot();
+}
+
+void UniformBuffer::advanceRegion()
+{
+    currentFrame_ = (currentFrame_ + 1) % fences_.size();
+    currentSlot_ = 0;
+
+    // Le GPU a normalement terminé cette région depuis deux images; l'attente est rare.
+    GLsync& fence = fences_[currentFrame_];
+    if (fence)
+    {
+        const GLuint64 TIMEOUT_NS = 1000000;
+        GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, TIMEOUT_NS);
+        while (status == GL_TIMEOUT_EXPIRED)
+            status = glClientWaitSync(fence, GL_NONE_BIT, TIMEOUT_NS);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
+
+void UniformBuffer::endFrame()
+{
+    if (!isRing_)
+        return;
+
+    fences_[currentFrame_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, GL_NONE_BIT);
+}
+
+void UniformBuffer::writeRingSlot()
+{
+    GLsizeiptr offset = (currentFrame_ * slotsPerFrame_ + currentSlot_) * slotSize_;
+    std::memcpy(mappedData_ + offset, shadow_.data(), byteSize_);
+}
+
+void UniformBuffer::bindRingSlot()
+{
+    GLsizeiptr offset = (currentFrame_ * slotsPerFrame_ + currentSlot_) * slotSize_;
+    glBindBufferRange(GL_UNIFORM_BUFFER, bindingIndex_, id_, offset, byteSize_);
+}
@@ -1,6 +1,8 @@
 #ifndef UNIFORM_BUFFER_H
 #define UNIFORM_BUFFER_H
 
+#include <vector>
+
 #include <glbinding/gl/gl.h>
 
 using namespace gl;
@@ -13,12 +15,40 @@ public:
     
     void allocate(const void* data, GLsizeiptr byteSize);
     
+    // Mode anneau: nFrames régions mappées de façon persistante, chacune avec
+    // maxUpdatesPerFrame copies du bloc. Chaque updateData écrit une nouvelle
+    // copie et la lie avec glBindBufferRange, sans synchronisation implicite.
+    // beginFrame()/endFrame() doivent encadrer chaque image. Au-delà de
+    // maxUpdatesPerFrame, l'image continue dans la région suivante après avoir
+    // attendu le GPU.
+    void allocateRing(const void* data, GLsizeiptr byteSize, unsigned int maxUpdatesPerFrame, unsigned int nFrames = 3);
+    
     void setBindingIndex(GLuint index);
 
     void updateData(const void* data, GLintptr offset, GLsizeiptr byteSize);
     
+    void beginFrame();
+    void endFrame();
+    
+private:
+    void advanceRegion();
+    void writeRingSlot();
+    void bindRingSlot();
+    
 private:
     GLuint id_;
+    GLsizeiptr byteSize_;
+    GLuint bindingIndex_;
+    
+    // Mode anneau
+    bool isRing_;
+    unsigned char* mappedData_;
+    std::vector<unsigned char> shadow_;
+    GLsizeiptr slotSize_;
+    unsigned int slotsPerFrame_;
+    unsigned int currentFrame_;
+    unsigned int currentSlot_;
+    std::vector<GLsync> fences_;
 };
 
 #endif // UNIFORM_BUFFER_H